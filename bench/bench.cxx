@@ -0,0 +1,355 @@
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+#include "json-lib/json.hpp"
+
+// every allocation of the process is counted, a case reports what one run of it allocates
+static std::atomic<std::size_t> allocations{ 0 };
+static std::atomic<std::size_t> allocatedBytes{ 0 };
+
+static void * countedAllocate(std::size_t n) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(n, std::memory_order_relaxed);
+    if (auto p = std::malloc(n != 0 ? n : 1)) { return p; }
+    throw std::bad_alloc();
+}
+
+void * operator new(std::size_t n) { return countedAllocate(n); }
+void * operator new[](std::size_t n) { return countedAllocate(n); }
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete[](void * p) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void * p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+    struct options_t {
+        std::size_t reps = 20;
+        std::size_t warmup = 3;
+        std::size_t size = 4 << 20;
+        std::string filter;
+        std::string format = "text";
+        std::string data = JSON_BENCH_DATA;
+    };
+
+    struct corpus_t {
+        std::string name;
+        std::string text;
+        std::size_t docs;
+        bool ndjson;
+    };
+
+    struct result_t {
+        std::string corpus;
+        std::string name;
+        std::size_t bytes;
+        std::size_t docs;
+        std::vector<double> ns;
+        std::size_t allocations;
+        std::size_t allocatedBytes;
+
+        double percentile(double p) const {
+            const auto i = static_cast<std::size_t>(p * static_cast<double>(ns.size() - 1) + 0.5);
+            return ns[i];
+        }
+
+        double mbPerSecond() const { return static_cast<double>(bytes) / (1 << 20) / (percentile(0.5) * 1e-9); }
+        double docsPerSecond() const { return static_cast<double>(docs) / (percentile(0.5) * 1e-9); }
+    };
+
+    // deterministic generators, every corpus is about target bytes
+    struct generator {
+        std::mt19937_64 r{ 42 };
+        std::size_t target;
+
+        explicit generator(std::size_t target) : target(target) {}
+
+        std::size_t pick(std::size_t n) { return static_cast<std::size_t>(r() % n); }
+
+        std::string number() {
+            switch (pick(4)) {
+                case 0: return std::to_string(static_cast<long long>(r() % 2000000) - 1000000);
+                case 1: return std::to_string(r());
+                case 2: {
+                    std::ostringstream s;
+                    s << std::setprecision(17) << (static_cast<double>(r() % 100000000) / 997.0 - 50000.0);
+                    return s.str();
+                }
+                default: return std::to_string(pick(1000)) + "." + std::to_string(pick(1000)) + "e" + (pick(2) ? "-" : "") + std::to_string(pick(300));
+            }
+        }
+
+        std::string literal(std::size_t n) {
+            static const char * pieces[] = { "\\n", "\\\"", "\\\\", "\\r", "\xc3\xa9", "\xe2\x82\xac", "\\t", "/", "\\u00e9", "\\ud83d\\ude00" };
+            std::string s = "\"";
+            for (std::size_t i = 0; i < n; ++i) {
+                if (pick(20) == 0) {
+                    s += pieces[pick(sizeof(pieces) / sizeof(*pieces))];
+                } else {
+                    s += static_cast<char>('a' + pick(26));
+                }
+            }
+            return s + "\"";
+        }
+
+        std::string record(std::size_t id) {
+            std::string s = "{\"id\":" + std::to_string(id) + ",\"name\":" + literal(8 + pick(24)) + ",\"score\":" + number()
+                + ",\"active\":" + (pick(2) ? "true" : "false") + ",\"tags\":[";
+            for (std::size_t i = 0, n = pick(5); i < n; ++i) { s += (i != 0 ? "," : "") + literal(3 + pick(6)); }
+            return s + "],\"position\":{\"x\":" + number() + ",\"y\":" + number() + "},\"parent\":null}";
+        }
+
+        corpus_t numbers() {
+            std::string s = "[";
+            while (s.size() < target) {
+                s += s.size() > 1 ? ",[" : "[";
+                for (int i = 0; i < 10; ++i) { s += (i != 0 ? "," : "") + number(); }
+                s += "]";
+            }
+            return { "numbers", s + "]", 1, false };
+        }
+
+        corpus_t strings() {
+            std::string s = "[";
+            while (s.size() < target) { s += (s.size() > 1 ? "," : "") + literal(5 + pick(60)); }
+            return { "strings", s + "]", 1, false };
+        }
+
+        corpus_t nested() {
+            std::string s = "[";
+            while (s.size() < target) {
+                const auto depth = 16 + pick(112);
+                std::string open;
+                std::string close;
+                for (std::size_t d = 0; d < depth; ++d) {
+                    if (d % 2 == 0) {
+                        open += "{\"k" + std::to_string(d) + "\":";
+                        close = "}" + close;
+                    } else {
+                        open += "[" + number() + ",";
+                        close = "]" + close;
+                    }
+                }
+                s += (s.size() > 1 ? "," : "") + open + "null" + close;
+            }
+            return { "nested", s + "]", 1, false };
+        }
+
+        corpus_t wide() {
+            std::string s = "[";
+            while (s.size() < target) {
+                s += s.size() > 1 ? ",{" : "{";
+                for (int i = 0; i < 256; ++i) { s += std::string(i != 0 ? "," : "") + "\"field_" + std::to_string(i) + "\":" + (pick(2) ? number() : literal(4)); }
+                s += "}";
+            }
+            return { "wide", s + "]", 1, false };
+        }
+
+        corpus_t ndjson() {
+            std::string s;
+            std::size_t n = 0;
+            while (s.size() < target) { s += record(n++) + "\n"; }
+            return { "ndjson", s, n, true };
+        }
+    };
+
+    struct sax_counter : json::sax::handler {
+        std::size_t n = 0;
+        bool onNumber(const json::sax::number_token &) { ++n; return true; }
+        bool onString(std::string_view) { ++n; return true; }
+        bool onKey(std::string_view) { ++n; return true; }
+    };
+
+    volatile std::size_t sink = 0;
+
+    result_t measure(const options_t & o, const corpus_t & c, const std::string & name, std::size_t bytes, const std::function<void()> & f) {
+        for (std::size_t i = 0; i < o.warmup; ++i) { f(); }
+        result_t r{ c.name, name, bytes, c.docs, {}, 0, 0 };
+        for (std::size_t i = 0; i < o.reps; ++i) {
+            const auto t0 = std::chrono::steady_clock::now();
+            f();
+            const auto t1 = std::chrono::steady_clock::now();
+            r.ns.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+        }
+        std::sort(r.ns.begin(), r.ns.end());
+        const auto a = allocations.load();
+        const auto b = allocatedBytes.load();
+        f();
+        r.allocations = allocations.load() - a;
+        r.allocatedBytes = allocatedBytes.load() - b;
+        return r;
+    }
+
+    std::vector<result_t> run(const options_t & o, const corpus_t & c) {
+        std::vector<result_t> results;
+        const auto selected = [&](const std::string & name) { return o.filter.empty() || (c.name + "/" + name).find(o.filter) != std::string::npos; };
+        const auto add = [&](const std::string & name, std::size_t bytes, const std::function<void()> & f) {
+            if (selected(name)) { results.push_back(measure(o, c, name, bytes, f)); }
+        };
+        const auto & t = c.text;
+
+        if (c.ndjson) {
+            add("stream", t.size(), [&] {
+                std::size_t n = 0;
+                for (const auto & d : json::document_stream{ t }) { n += d ? 1 : 0; }
+                sink = n;
+            });
+            add("parallel", t.size(), [&] { sink = json::parallel::parse(t, [](const json::arena::var::ptr_t &) {}); });
+            return results;
+        }
+
+        add("parse", t.size(), [&] { sink = json::parse(t) ? 1 : 0; });
+        add("document", t.size(), [&] {
+            json::document d;
+            d.parse(t);
+            sink = d.bytesAllocated();
+        });
+        add("view-insitu", t.size(), [&] {
+            std::string m = t;
+            json::view_document d;
+            d.parseInSitu(&m[0], &m[0] + m.size());
+            sink = d.bytesAllocated();
+        });
+        add("compact", t.size(), [&] { sink = json::compact::parse(t).isObject() ? 1 : 0; });
+        add("tape", t.size(), [&] {
+            json::tape p;
+            p.parse(t);
+            sink = p.entries().size();
+        });
+        add("sax", t.size(), [&] {
+            sax_counter h;
+            json::sax::parse(t, h);
+            sink = h.n;
+        });
+        add("parse-parallel", t.size(), [&] { sink = json::parse(t, json::parallel_options{}) ? 1 : 0; });
+
+        if (selected("serialize") || selected("serialize-indent")) {
+            json::document d;
+            d.parse(t);
+            const auto compact = json::to_string(*d.root());
+            const auto indented = json::to_string(*d.root(), 2);
+            add("serialize", compact.size(), [&] { sink = json::to_string(*d.root()).size(); });
+            add("serialize-indent", indented.size(), [&] { sink = json::to_string(*d.root(), 2).size(); });
+        }
+
+        // the same tree as CBOR and MessagePack, sizes are those of the encoding
+        if (selected("cbor") || selected("msgpack")) {
+            const auto tree = json::parse(t);
+            const auto cbor = json::cbor::encode(*tree);
+            const auto msgpack = json::msgpack::encode(*tree);
+            add("cbor-encode", cbor.size(), [&] { sink = json::cbor::encode(*tree).size(); });
+            add("cbor-parse", cbor.size(), [&] { sink = json::cbor::parse(cbor) ? 1 : 0; });
+            add("cbor-document", cbor.size(), [&] {
+                json::document d;
+                d.parse(cbor, json::binary_format::cbor);
+                sink = d.bytesAllocated();
+            });
+            add("msgpack-encode", msgpack.size(), [&] { sink = json::msgpack::encode(*tree).size(); });
+            add("msgpack-parse", msgpack.size(), [&] { sink = json::msgpack::parse(msgpack) ? 1 : 0; });
+        }
+        return results;
+    }
+
+    void printText(const std::vector<result_t> & results) {
+        std::printf("%-10s %-17s %10s %10s %10s %10s %10s %12s %12s %12s\n", "corpus", "case", "kb", "min ms", "p50 ms", "p90 ms", "p99 ms", "MB/s", "docs/s", "allocs");
+        for (const auto & r : results) {
+            std::printf("%-10s %-17s %10zu %10.3f %10.3f %10.3f %10.3f %12.1f %12.0f %12zu\n", r.corpus.c_str(), r.name.c_str(), r.bytes / 1024,
+                r.ns.front() * 1e-6, r.percentile(0.5) * 1e-6, r.percentile(0.9) * 1e-6, r.percentile(0.99) * 1e-6, r.mbPerSecond(), r.docsPerSecond(), r.allocations);
+        }
+    }
+
+    void printJson(const options_t & o, const std::vector<result_t> & results) {
+#if defined(NDEBUG)
+        const auto assertions = "false";
+#else
+        const auto assertions = "true";
+#endif
+        std::printf("{\n  \"reps\": %zu,\n  \"warmup\": %zu,\n  \"threads\": %u,\n  \"assertions\": %s,\n  \"results\": [", o.reps, o.warmup, std::thread::hardware_concurrency(), assertions);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const auto & r = results[i];
+            std::printf("%s\n    {\"corpus\": \"%s\", \"case\": \"%s\", \"bytes\": %zu, \"docs\": %zu, \"min_ns\": %.0f, \"p50_ns\": %.0f, \"p90_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f, "
+                "\"mb_per_s\": %.2f, \"docs_per_s\": %.1f, \"allocations\": %zu, \"allocated_bytes\": %zu}",
+                i != 0 ? "," : "", r.corpus.c_str(), r.name.c_str(), r.bytes, r.docs, r.ns.front(), r.percentile(0.5), r.percentile(0.9), r.percentile(0.99), r.ns.back(),
+                r.mbPerSecond(), r.docsPerSecond(), r.allocations, r.allocatedBytes);
+        }
+        std::printf("\n  ]\n}\n");
+    }
+
+    void printCsv(const std::vector<result_t> & results) {
+        std::printf("corpus,case,bytes,docs,min_ns,p50_ns,p90_ns,p99_ns,max_ns,mb_per_s,docs_per_s,allocations,allocated_bytes\n");
+        for (const auto & r : results) {
+            std::printf("%s,%s,%zu,%zu,%.0f,%.0f,%.0f,%.0f,%.0f,%.2f,%.1f,%zu,%zu\n", r.corpus.c_str(), r.name.c_str(), r.bytes, r.docs, r.ns.front(), r.percentile(0.5),
+                r.percentile(0.9), r.percentile(0.99), r.ns.back(), r.mbPerSecond(), r.docsPerSecond(), r.allocations, r.allocatedBytes);
+        }
+    }
+
+    int usage() {
+        std::fprintf(stderr, "usage: json-bench [--reps n] [--warmup n] [--size bytes] [--filter corpus/case] [--format text|json|csv] [--data file] [--quick]\n");
+        return 2;
+    }
+
+}
+
+int main(int argc, char ** argv) {
+    options_t o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const auto value = [&]() -> std::string {
+            if (i + 1 >= argc) { throw std::invalid_argument(a + " needs a value"); }
+            return argv[++i];
+        };
+        if (a == "--reps") {
+            o.reps = std::stoul(value());
+        } else if (a == "--warmup") {
+            o.warmup = std::stoul(value());
+        } else if (a == "--size") {
+            o.size = std::stoul(value());
+        } else if (a == "--filter") {
+            o.filter = value();
+        } else if (a == "--format") {
+            o.format = value();
+        } else if (a == "--data") {
+            o.data = value();
+        } else if (a == "--quick") {
+            o.reps = 2;
+            o.warmup = 0;
+            o.size = 64 << 10;
+        } else {
+            return usage();
+        }
+    }
+    if (o.reps == 0 || (o.format != "text" && o.format != "json" && o.format != "csv")) { return usage(); }
+
+    generator g{ o.size };
+    std::vector<corpus_t> corpora{ g.numbers(), g.strings(), g.nested(), g.wide(), g.ndjson() };
+    if (std::ifstream f{ o.data }) { corpora.push_back({ "data.json", std::string{ std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() }, 1, false }); }
+
+    std::vector<result_t> results;
+    for (const auto & c : corpora) {
+        auto r = run(o, c);
+        results.insert(results.end(), std::make_move_iterator(r.begin()), std::make_move_iterator(r.end()));
+    }
+
+    if (o.format == "json") {
+        printJson(o, results);
+    } else if (o.format == "csv") {
+        printCsv(results);
+    } else {
+        printText(results);
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+
+#ifndef HEADER_JSON_PARSER_ARENA
+#define HEADER_JSON_PARSER_ARENA 1
+
+#include <new>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+#include "definition.hpp"
+
+namespace json {
+    namespace details {
+
+        // monotonic block allocator, memory is only returned in one shot by reset() or destruction
+        struct arena {
+
+            struct block_t {
+                block_t * next;
+                std::size_t size;
+            };
+
+            static constexpr std::size_t defaultBlockSize = 1 << 16;
+            static constexpr std::size_t maxBlockSize = 1 << 24;
+
+            explicit arena(std::size_t blockSize = defaultBlockSize) noexcept : blockSize(blockSize < sizeof(block_t) * 2 ? sizeof(block_t) * 2 : blockSize) {}
+
+            arena(const arena &) = delete;
+            arena & operator=(const arena &) = delete;
+
+            arena(arena && m) noexcept : head(m.head), cur(m.cur), end(m.end), blockSize(m.blockSize), used(m.used) {
+                m.head = nullptr;
+                m.cur = m.end = nullptr;
+                m.used = 0;
+            }
+
+            arena & operator=(arena && m) noexcept {
+                if (this != &m) {
+                    freeBlocks(head);
+                    head = m.head;
+                    cur = m.cur;
+                    end = m.end;
+                    blockSize = m.blockSize;
+                    used = m.used;
+                    m.head = nullptr;
+                    m.cur = m.end = nullptr;
+                    m.used = 0;
+                }
+                return *this;
+            }
+
+            ~arena() { freeBlocks(head); }
+
+            void * allocate(std::size_t n, std::size_t align = alignof(std::max_align_t)) {
+                auto p = alignUp(cur, align);
+                if (p == nullptr || n > static_cast<std::size_t>(end - p)) {
+                    grow(n + align);
+                    p = alignUp(cur, align);
+                }
+                cur = p + n;
+                used += n;
+                return p;
+            }
+
+            template<typename x>
+            x * allocate(std::size_t n = 1) { return static_cast<x *>(allocate(sizeof(x) * n, alignof(x))); }
+
+            // keeps the largest block for reuse
+            void reset() noexcept {
+                if (head != nullptr) {
+                    auto k = head;
+                    for (auto b = head->next; b != nullptr; b = b->next) {
+                        if (b->size > k->size) { k = b; }
+                    }
+                    for (auto b = head; b != nullptr;) {
+                        const auto n = b->next;
+                        if (b != k) { ::operator delete(static_cast<void *>(b)); }
+                        b = n;
+                    }
+                    k->next = nullptr;
+                    head = k;
+                    cur = data(k);
+                    end = reinterpret_cast<char *>(k) + k->size;
+                }
+                used = 0;
+            }
+
+            std::size_t bytesAllocated() const noexcept { return used; }
+
+            std::size_t bytesReserved() const noexcept {
+                std::size_t r = 0;
+                for (auto b = head; b != nullptr; b = b->next) { r += b->size; }
+                return r;
+            }
+
+        private:
+
+            block_t * head = nullptr;
+            char * cur = nullptr;
+            char * end = nullptr;
+            std::size_t blockSize;
+            std::size_t used = 0;
+
+            static char * data(block_t * b) noexcept { return reinterpret_cast<char *>(b) + sizeof(block_t); }
+
+            static char * alignUp(char * p, std::size_t align) noexcept {
+                if (p == nullptr) { return nullptr; }
+                auto v = reinterpret_cast<std::uintptr_t>(p);
+                return p + ((align - (v & (align - 1))) & (align - 1));
+            }
+
+            static void freeBlocks(block_t * b) noexcept {
+                while (b != nullptr) {
+                    auto n = b->next;
+                    ::operator delete(static_cast<void *>(b));
+                    b = n;
+                }
+            }
+
+            void grow(std::size_t n) {
+                auto size = blockSize;
+                while (size - sizeof(block_t) < n) { size *= 2; }
+                auto b = static_cast<block_t *>(::operator new(size));
+                b->next = head;
+                b->size = size;
+                head = b;
+                cur = data(b);
+                end = reinterpret_cast<char *>(b) + size;
+                if (blockSize < maxBlockSize) { blockSize *= 2; }
+            }
+
+        };
+
+        // allocates from an arena, a default constructed allocator falls back to the global heap
+        template<typename x>
+        struct arena_allocator {
+            using value_type = x;
+            using propagate_on_container_copy_assignment = std::true_type;
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_swap = std::true_type;
+
+            arena * a = nullptr;
+
+            arena_allocator() noexcept = default;
+            arena_allocator(arena * a) noexcept : a(a) {}
+            template<typename y>
+            arena_allocator(const arena_allocator<y> & o) noexcept : a(o.a) {}
+
+            x * allocate(std::size_t n) {
+                if (a != nullptr) { return a->template allocate<x>(n); }
+                return static_cast<x *>(::operator new(sizeof(x) * n));
+            }
+
+            void deallocate(x * p, std::size_t) noexcept {
+                if (a == nullptr) { ::operator delete(static_cast<void *>(p)); }
+            }
+
+            template<typename y>
+            bool operator==(const arena_allocator<y> & o) const noexcept { return a == o.a; }
+            template<typename y>
+            bool operator!=(const arena_allocator<y> & o) const noexcept { return a != o.a; }
+        };
+
+        // non-owning pointer to an arena-allocated node, the arena releases the pointee
+        template<typename x>
+        struct arena_ptr {
+            arena_ptr() noexcept = default;
+            arena_ptr(decltype(nullptr)) noexcept {}
+            arena_ptr(x * p) noexcept : p(p) {}
+            template<typename y, typename = std::enable_if_t<std::is_convertible<y *, x *>::value>>
+            arena_ptr(const arena_ptr<y> & o) noexcept : p(o.get()) {}
+
+            x * get() const noexcept { return p; }
+            x * release() noexcept { return std::exchange(p, nullptr); }
+            void reset(x * n = nullptr) noexcept { p = n; }
+
+            x & operator*() const noexcept { return *p; }
+            x * operator->() const noexcept { return p; }
+            explicit operator bool() const noexcept { return p != nullptr; }
+
+        private:
+            x * p = nullptr;
+        };
+
+        template<typename key_t, typename value_t>
+        using arena_map = std::map<key_t, value_t, std::less<key_t>, arena_allocator<std::pair<const key_t, value_t>>>;
+
+        template<typename value_t>
+        using arena_vector = std::vector<value_t, arena_allocator<value_t>>;
+
+        using arena_string = std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
+
+        // places nodes, container storage and literals of a parse in an arena,
+        // nodes are never destroyed so every allocation they make has to come from the same arena
+        template<typename definition_t>
+        struct arena_factory : tree_factory<definition_t, arena_factory<definition_t>> {
+            using object_t = typename definition_t::object_t;
+            using array_t = typename definition_t::array_t;
+            using literal_t = typename definition_t::literal_t;
+
+            explicit arena_factory(arena * a) noexcept : a(a) {}
+
+            arena * a;
+
+            template<typename x, typename ... args_t>
+            x * make(args_t && ... args) {
+                auto m = a->template allocate<x>();
+                if constexpr (std::is_same<x, object_t>::value || std::is_same<x, array_t>::value) {
+                    return new (m) x(std::forward<args_t>(args)..., typename x::base_t::allocator_type(a));
+                } else {
+                    return new (m) x(std::forward<args_t>(args)...);
+                }
+            }
+
+            // literals are views into the parsed text with a std::string_view literal_t, the text is decoded in place
+            static constexpr bool views = std::is_same<literal_t, std::string_view>::value;
+
+            literal_t literal() { return literal_t(typename literal_t::allocator_type(a)); }
+
+            literal_t literal(std::string_view v) {
+                if constexpr (views) {
+                    return { static_cast<const char *>(std::memcpy(a->template allocate<char>(v.size()), v.data(), v.size())), v.size() };
+                } else {
+                    return literal_t(v.data(), v.size(), typename literal_t::allocator_type(a));
+                }
+            }
+
+            literal_t copyLiteral(std::string_view v) { return literal(v); }
+
+            literal_t readLiteral(const char *& p, const char * e, parse_stats * stats = nullptr) {
+                if constexpr (views) {
+                    return readLiteralInSitu(p, e, stats);
+                } else {
+                    return tree_factory<definition_t, arena_factory<definition_t>>::readLiteral(p, e, stats);
+                }
+            }
+        };
+
+        // document::parse() of another input selected by an option_t, specialized next to option_t:
+        // binary_format in binary.hpp, parse_limits in limits.hpp
+        template<typename option_t>
+        struct document_reader;
+
+        // owns a parsed tree and the arena backing it, the whole tree is freed at once; the arena is held apart so that
+        // the allocators in the tree keep pointing at it when the document is moved, a moved-from document can only be
+        // destroyed or assigned to
+        template<typename definition_t_>
+        struct document {
+
+            using definition_t = definition_t_;
+            using var_t = typename definition_t::var_t;
+            using literal_t = typename definition_t::literal_t;
+            using ptr_t = typename var_t::ptr_t;
+            using factory_t = arena_factory<definition_t>;
+
+            explicit document(std::size_t blockSize = arena::defaultBlockSize) : a(std::make_unique<arena>(blockSize)) {}
+
+            document(const document &) = delete;
+            document & operator=(const document &) = delete;
+            document(document &&) = default;
+            document & operator=(document &&) = default;
+
+            // replaces the current tree, the arena keeps its largest block between parses;
+            // with std::string_view literals the text is copied into the arena once and the literals refer to the copy
+            document & parse(const char * begin, const char * end) { return read(begin, end, no_stats{}); }
+
+            document & parse(std::string_view s) { return parse(s.data(), s.data() + s.size()); }
+
+            // as parse(), adding what it reads and the arena bytes it takes to stats
+            document & parse(const char * begin, const char * end, parse_stats & stats) {
+                read(begin, end, stats_recorder{ &stats });
+                stats.arenaBytes += a->bytesAllocated();
+                return *this;
+            }
+
+            document & parse(std::string_view s, parse_stats & stats) { return parse(s.data(), s.data() + s.size(), stats); }
+
+            // [begin, end) read as o asks, see document_reader
+            template<typename option_t, typename reader_t = document_reader<option_t>>
+            document & parse(const char * begin, const char * end, const option_t & o) { return reader_t::read(*this, begin, end, o); }
+
+            template<typename option_t, typename reader_t = document_reader<option_t>>
+            document & parse(std::string_view s, const option_t & o) { return parse(s.data(), s.data() + s.size(), o); }
+
+            // with std::string_view literals escaped literals are decoded into [begin, end) and every literal refers to it,
+            // the buffer has to outlive the tree
+            document & parseInSitu(char * begin, char * end) {
+                clear();
+                r = parser<definition_t, factory_t>::parse(begin, end, factory());
+                return *this;
+            }
+
+            const ptr_t & root() const noexcept { return r; }
+
+            document & root(ptr_t n) noexcept {
+                r = std::move(n);
+                return *this;
+            }
+
+            // nodes and literals attached to this document must be created through it
+            template<typename x, typename ... args_t>
+            x * make(args_t && ... args) { return factory().template make<x>(std::forward<args_t>(args)...); }
+
+            literal_t literal(std::string_view v) { return factory().literal(v); }
+
+            void clear() noexcept {
+                r = nullptr;
+                a->reset();
+            }
+
+            std::size_t bytesAllocated() const noexcept { return a->bytesAllocated(); }
+
+            std::size_t bytesReserved() const noexcept { return a->bytesReserved(); }
+
+        private:
+
+            template<typename option_t>
+            friend struct document_reader;
+
+            std::unique_ptr<arena> a;
+            ptr_t r;
+
+            factory_t factory() noexcept { return factory_t{ a.get() }; }
+
+            template<typename stats_t>
+            document & read(const char * begin, const char * end, stats_t stats) {
+                clear();
+                if constexpr (factory_t::views) {
+                    const auto n = static_cast<std::size_t>(end - begin);
+                    const auto b = a->template allocate<char>(n);
+                    std::memcpy(b, begin, n);
+                    begin = b;
+                    end = b + n;
+                }
+                r = parser<definition_t, factory_t, stats_t>::parse(begin, end, factory(), std::move(stats));
+                return *this;
+            }
+
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,579 @@
+
+#ifndef HEADER_JSON_PARSER_BINARY
+#define HEADER_JSON_PARSER_BINARY 1
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include "definition.hpp"
+
+namespace json {
+
+    enum struct binary_format : unsigned char { cbor, msgpack };
+
+    namespace details {
+
+        // appends CBOR or MessagePack items to a string; containers are written with their element count first,
+        // integral numbers as integers and floating ones as float32 when that is exact
+        struct binary_writer {
+            binary_format f;
+            std::string out;
+
+            explicit binary_writer(binary_format f) noexcept : f(f) {}
+
+            void null() { put(cbor() ? 0xf6 : 0xc0); }
+
+            void boolean(bool b) { put(cbor() ? (b ? 0xf5 : 0xf4) : (b ? 0xc3 : 0xc2)); }
+
+            void uinteger(std::uint64_t u) {
+                if (cbor()) {
+                    head(0, u);
+                } else if (u < 0x80) {
+                    put(static_cast<unsigned>(u));
+                } else {
+                    sized(0xcc, u, true);
+                }
+            }
+
+            void integer(std::int64_t i) {
+                if (i >= 0) {
+                    uinteger(static_cast<std::uint64_t>(i));
+                } else if (cbor()) {
+                    head(1, static_cast<std::uint64_t>(-1 - i));
+                } else if (i >= -32) {
+                    put(static_cast<unsigned>(i) & 0xff);
+                } else {
+                    // the smallest of int8 to int64 that holds i
+                    const auto n = i >= std::numeric_limits<std::int8_t>::min() ? 1 : i >= std::numeric_limits<std::int16_t>::min() ? 2 : i >= std::numeric_limits<std::int32_t>::min() ? 4 : 8;
+                    put(0xd0 + (n == 1 ? 0 : n == 2 ? 1 : n == 4 ? 2 : 3));
+                    big(static_cast<std::uint64_t>(i), n);
+                }
+            }
+
+            void floating(double d) {
+                if (d != d || (std::fabs(d) <= std::numeric_limits<float>::max() && static_cast<double>(static_cast<float>(d)) == d)) {
+                    const auto s = static_cast<float>(d);
+                    std::uint32_t b;
+                    std::memcpy(&b, &s, sizeof(b));
+                    put(cbor() ? 0xfa : 0xca);
+                    big(b, 4);
+                } else {
+                    std::uint64_t b;
+                    std::memcpy(&b, &d, sizeof(b));
+                    put(cbor() ? 0xfb : 0xcb);
+                    big(b, 8);
+                }
+            }
+
+            template<typename number_t>
+            void number(const number_t & n) {
+                if constexpr (std::is_integral<number_t>::value) {
+                    if constexpr (std::is_signed<number_t>::value) {
+                        integer(static_cast<std::int64_t>(n));
+                    } else {
+                        uinteger(static_cast<std::uint64_t>(n));
+                    }
+                } else {
+                    const auto d = static_cast<double>(n);
+                    // -0.0 stays floating to keep its sign
+                    if (d == std::trunc(d) && !(d == 0 && std::signbit(d)) && d >= -9223372036854775808.0 && d < 18446744073709551616.0) {
+                        if (d < 0) {
+                            integer(static_cast<std::int64_t>(d));
+                        } else {
+                            uinteger(static_cast<std::uint64_t>(d));
+                        }
+                    } else {
+                        floating(d);
+                    }
+                }
+            }
+
+            void text(std::string_view v) {
+                if (cbor()) {
+                    head(3, v.size());
+                } else if (v.size() < 32) {
+                    put(0xa0 | static_cast<unsigned>(v.size()));
+                } else {
+                    sized(0xd9, v.size(), true);
+                }
+                out.append(v.data(), v.size());
+            }
+
+            void array(std::size_t n) {
+                if (cbor()) {
+                    head(4, n);
+                } else if (n < 16) {
+                    put(0x90 | static_cast<unsigned>(n));
+                } else {
+                    sized(0xdc, n, false);
+                }
+            }
+
+            void object(std::size_t n) {
+                if (cbor()) {
+                    head(5, n);
+                } else if (n < 16) {
+                    put(0x80 | static_cast<unsigned>(n));
+                } else {
+                    sized(0xde, n, false);
+                }
+            }
+
+        private:
+
+            bool cbor() const noexcept { return f == binary_format::cbor; }
+
+            void put(unsigned c) { out.push_back(static_cast<char>(c)); }
+
+            void big(std::uint64_t v, int n) {
+                for (int i = n - 1; i >= 0; --i) { put(static_cast<unsigned>(v >> (8 * i)) & 0xff); }
+            }
+
+            // CBOR initial byte, the argument follows in the fewest bytes
+            void head(unsigned major, std::uint64_t n) {
+                major <<= 5;
+                if (n < 24) {
+                    put(major | static_cast<unsigned>(n));
+                } else if (n <= 0xff) {
+                    put(major | 24);
+                    big(n, 1);
+                } else if (n <= 0xffff) {
+                    put(major | 25);
+                    big(n, 2);
+                } else if (n <= 0xffffffff) {
+                    put(major | 26);
+                    big(n, 4);
+                } else {
+                    put(major | 27);
+                    big(n, 8);
+                }
+            }
+
+            // MessagePack type bytes for 8, 16, 32 (and 64) bit sizes follow each other from t;
+            // strings have an 8 bit form, containers start at 16 bits
+            void sized(unsigned t, std::uint64_t n, bool byteForm) {
+                if (byteForm && n <= 0xff) {
+                    put(t);
+                    big(n, 1);
+                    return;
+                }
+                if (byteForm) { ++t; }
+                if (n <= 0xffff) {
+                    put(t);
+                    big(n, 2);
+                } else if (n <= 0xffffffff) {
+                    put(t + 1);
+                    big(n, 4);
+                } else if (t == 0xcd) {
+                    put(0xcf);
+                    big(n, 8);
+                } else {
+                    throw std::length_error("json value too large for msgpack");
+                }
+            }
+        };
+
+        template<typename x, typename = void>
+        struct node_pointer : std::false_type {};
+
+        template<typename x>
+        struct node_pointer<x, std::void_t<decltype(*std::declval<const x &>())>> : std::true_type {};
+
+        template<typename x, typename = void>
+        struct exact_integers : std::false_type {};
+
+        template<typename x>
+        struct exact_integers<x, std::void_t<decltype(std::declval<const x &>().isInteger())>> : std::true_type {};
+
+        template<typename value_t>
+        inline static void writeBinary(binary_writer & w, const value_t & v);
+
+        // tree definitions hold elements by pointer and a null pointer is written as null, compact values are held directly
+        template<typename element_t>
+        inline static void writeBinaryElement(binary_writer & w, const element_t & e) {
+            if constexpr (node_pointer<element_t>::value) {
+                if (e) {
+                    writeBinary(w, *e);
+                } else {
+                    w.null();
+                }
+            } else {
+                writeBinary(w, e);
+            }
+        }
+
+        // writes v, a node of any tree definition or a compact value
+        template<typename value_t>
+        inline static void writeBinary(binary_writer & w, const value_t & v) {
+            if (const auto o = v.tryAsObject()) {
+                w.object(o->size());
+                for (const auto & i : *o) {
+                    w.text(std::string_view(i.first.data(), i.first.size()));
+                    writeBinaryElement(w, i.second);
+                }
+                return;
+            }
+            if (const auto a = v.tryAsArray()) {
+                w.array(a->size());
+                for (const auto & i : *a) { writeBinaryElement(w, i); }
+                return;
+            }
+            const auto & p = v.asPrimitive();
+            using type_t = decltype(p.type());
+            switch (p.type()) {
+                case type_t::number:
+                {
+                    if constexpr (exact_integers<std::decay_t<decltype(p)>>::value) {
+                        if (p.isInteger()) {
+                            if (p.number() < 0) {
+                                w.integer(p.integer());
+                            } else {
+                                w.uinteger(p.uinteger());
+                            }
+                            break;
+                        }
+                    }
+                    w.number(p.number());
+                    break;
+                }
+                case type_t::literal:
+                {
+                    const auto & l = p.literal();
+                    w.text(std::string_view(l.data(), l.size()));
+                    break;
+                }
+                case type_t::boolean: w.boolean(static_cast<bool>(p.boolean())); break;
+                default: w.null(); break;
+            }
+        }
+
+        // decodes one CBOR or MessagePack item into a tree built by factory_t, without recursion; a container's size
+        // is known when it opens, so its storage is reserved, up to what the remaining bytes can hold against hostile sizes.
+        // CBOR tags are skipped, byte strings, non-text keys and MessagePack extensions have no json form and throw
+        template<typename definition_t_, typename factory_t_ = heap_factory<definition_t_>>
+        struct binary_parser {
+
+            using definition_t = definition_t_;
+            using factory_t = factory_t_;
+
+            using value_t = typename factory_t::value_t;
+            using object_t = typename definition_t::object_t;
+            using array_t = typename definition_t::array_t;
+            using key_t = typename factory_t::key_t;
+
+            // elements left to read, indefinite CBOR containers end at a break byte instead
+            static constexpr std::size_t indefinite = std::numeric_limits<std::size_t>::max();
+
+            struct frame_t {
+                object_t * o;
+                array_t * a;
+                std::size_t n;
+            };
+
+            binary_format f;
+            const char * begin;
+            const char * s;
+            const char * end;
+            factory_t factory;
+            std::vector<frame_t> frames;
+            value_t root;
+            key_t key;
+            std::string scratch;
+
+            binary_parser(binary_format f, const char * begin, const char * end, factory_t factory = {}) : f(f), begin(begin), s(begin), end(end), factory(std::move(factory)), root(), key() {}
+
+            long long charsRead() const noexcept { return static_cast<long long>(s - begin); }
+
+            // reads the item at the current position and leaves the parser past it
+            value_t read() {
+                do {
+                    if (!frames.empty() && frames.back().o != nullptr) { key = readKey(); }
+                    item();
+                    while (!frames.empty() && finished(frames.back())) {
+                        if (frames.back().o != nullptr) { factory.close(*frames.back().o); }
+                        frames.pop_back();
+                    }
+                } while (!frames.empty());
+                return std::move(root);
+            }
+
+            // [begin, end) has to hold a single item
+            static value_t parse(binary_format f, const char * begin, const char * end, factory_t factory = {}) {
+                binary_parser p{ f, begin, end, std::move(factory) };
+                auto r = p.read();
+                if (p.s != end) { p.malformed("trailing bytes"); }
+                return r;
+            }
+
+        private:
+
+            bool cbor() const noexcept { return f == binary_format::cbor; }
+
+            [[noreturn]] void truncated() const { throw std::runtime_error(cbor() ? "failed to read cbor" : "failed to read msgpack"); }
+
+            [[noreturn]] void malformed(const char * what) const { throw std::runtime_error(std::string(cbor() ? "failed to parse cbor: " : "failed to parse msgpack: ") + what); }
+
+            unsigned get() {
+                if (s == end) { truncated(); }
+                return static_cast<unsigned char>(*s++);
+            }
+
+            std::uint64_t big(int n) {
+                if (end - s < n) { truncated(); }
+                std::uint64_t r = 0;
+                for (int i = 0; i < n; ++i) { r = (r << 8) | static_cast<unsigned char>(*s++); }
+                return r;
+            }
+
+            std::string_view bytes(std::uint64_t n) {
+                if (static_cast<std::uint64_t>(end - s) < n) { truncated(); }
+                const std::string_view v(s, static_cast<std::size_t>(n));
+                s += n;
+                checkUtf8(v.data(), v.data() + v.size());
+                return v;
+            }
+
+            bool finished(frame_t & t) {
+                if (t.n != indefinite) { return t.n == 0; }
+                if (s != end && static_cast<unsigned char>(*s) == 0xff) {
+                    ++s;
+                    return true;
+                }
+                return false;
+            }
+
+            void attach(value_t && v) {
+                if (frames.empty()) {
+                    root = std::move(v);
+                    return;
+                }
+                auto & t = frames.back();
+                if (t.n != indefinite) { --t.n; }
+                if (t.o != nullptr) {
+                    factory.set(*t.o, std::move(key), std::move(v));
+                } else {
+                    factory.add(*t.a, std::move(v));
+                }
+            }
+
+            void open(bool object, std::size_t n) {
+                auto v = object ? factory.makeObject() : factory.makeArray();
+                const auto o = object ? factory.tryAsObject(v) : nullptr;
+                const auto a = object ? nullptr : factory.tryAsArray(v);
+                if (n != indefinite) {
+                    // every element takes at least one byte, a member two
+                    const auto room = static_cast<std::size_t>(end - s) / (object ? 2 : 1);
+                    if (object) {
+                        factory.reserve(*o, n < room ? n : room);
+                    } else {
+                        factory.reserve(*a, n < room ? n : room);
+                    }
+                }
+                attach(std::move(v));
+                if (n == 0) {
+                    if (object) { factory.close(*o); }
+                } else {
+                    frames.push_back(frame_t{ o, a, n });
+                }
+            }
+
+            void number(std::int64_t i) {
+                number_token t;
+                t.kind = number_token::kind_t::integer;
+                t.i = i;
+                attach(factory.makeNumber(t));
+            }
+
+            void number(std::uint64_t u) {
+                if (u <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) { return number(static_cast<std::int64_t>(u)); }
+                number_token t;
+                t.kind = number_token::kind_t::uinteger;
+                t.u = u;
+                attach(factory.makeNumber(t));
+            }
+
+            void number(double d) {
+                number_token t;
+                t.d = d;
+                attach(factory.makeNumber(t));
+            }
+
+            double float16(std::uint64_t h) {
+                const auto e = static_cast<int>((h >> 10) & 0x1f);
+                const auto m = static_cast<double>(h & 0x3ff);
+                const auto v = e == 0 ? std::ldexp(m, -24) : e == 31 ? (m == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN()) : std::ldexp(m + 1024, e - 25);
+                return (h & 0x8000) != 0 ? -v : v;
+            }
+
+            double float32(std::uint64_t b) {
+                const auto u = static_cast<std::uint32_t>(b);
+                float r;
+                std::memcpy(&r, &u, sizeof(r));
+                return r;
+            }
+
+            double float64(std::uint64_t b) {
+                double r;
+                std::memcpy(&r, &b, sizeof(r));
+                return r;
+            }
+
+            // the argument of a CBOR initial byte, info 31 marks an indefinite length and is handled by the callers
+            std::uint64_t argument(unsigned info) {
+                if (info < 24) { return info; }
+                switch (info) {
+                    case 24: return big(1);
+                    case 25: return big(2);
+                    case 26: return big(4);
+                    case 27: return big(8);
+                    default: malformed("reserved additional information");
+                }
+            }
+
+            // a definite count is never larger than the bytes left, so it cannot be taken for indefinite
+            std::size_t count(std::uint64_t n) {
+                if (n > static_cast<std::uint64_t>(end - s)) { truncated(); }
+                return static_cast<std::size_t>(n);
+            }
+
+            std::size_t cborCount(unsigned info) { return info == 31 ? indefinite : count(argument(info)); }
+
+            // a definite text, or the concatenated chunks of an indefinite one
+            std::string_view cborText(unsigned info) {
+                if (info != 31) { return bytes(argument(info)); }
+                scratch.clear();
+                for (;;) {
+                    const auto c = get();
+                    if (c == 0xff) { return scratch; }
+                    if ((c >> 5) != 3 || (c & 0x1f) == 31) { malformed("illegal text chunk"); }
+                    const auto v = bytes(argument(c & 0x1f));
+                    scratch.append(v.data(), v.size());
+                }
+            }
+
+            key_t readKey() {
+                const auto c = get();
+                if (cbor()) {
+                    if ((c >> 5) != 3) { malformed("non-text key"); }
+                    return factory.copyKey(cborText(c & 0x1f));
+                }
+                if ((c & 0xe0) == 0xa0) { return factory.copyKey(bytes(c & 0x1f)); }
+                if (c >= 0xd9 && c <= 0xdb) { return factory.copyKey(bytes(big(1 << (c - 0xd9)))); }
+                malformed("non-text key");
+            }
+
+            void item() {
+                if (cbor()) {
+                    cborItem();
+                } else {
+                    msgpackItem();
+                }
+            }
+
+            void cborItem() {
+                for (;;) {
+                    const auto c = get();
+                    const auto info = c & 0x1f;
+                    switch (c >> 5) {
+                        case 0: return number(argument(info));
+                        case 1:
+                        {
+                            const auto n = argument(info);
+                            if (n <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) { return number(-1 - static_cast<std::int64_t>(n)); }
+                            return number(-1.0 - static_cast<double>(n));
+                        }
+                        case 2: malformed("byte strings have no json form");
+                        case 3: return attach(factory.makeLiteral(factory.copyLiteral(cborText(info))));
+                        case 4: return open(false, cborCount(info));
+                        case 5: return open(true, cborCount(info));
+                        case 6:
+                        {
+                            // the tagged item stands for itself
+                            argument(info);
+                            continue;
+                        }
+                        default:
+                        {
+                            switch (info) {
+                                case 20: return attach(factory.makeBoolean(False));
+                                case 21: return attach(factory.makeBoolean(True));
+                                case 22:
+                                case 23: return attach(factory.makeNull());
+                                case 25: return number(float16(big(2)));
+                                case 26: return number(float32(big(4)));
+                                case 27: return number(float64(big(8)));
+                                case 31: malformed("unexpected break");
+                                default: malformed("unsupported simple value");
+                            }
+                        }
+                    }
+                }
+            }
+
+            void msgpackItem() {
+                const auto c = get();
+                if (c < 0x80) { return number(static_cast<std::uint64_t>(c)); }
+                if (c >= 0xe0) { return number(static_cast<std::int64_t>(static_cast<std::int8_t>(c))); }
+                if (c < 0x90) { return open(true, count(c & 0x0f)); }
+                if (c < 0xa0) { return open(false, count(c & 0x0f)); }
+                if (c < 0xc0) { return attach(factory.makeLiteral(factory.copyLiteral(bytes(c & 0x1f)))); }
+                switch (c) {
+                    case 0xc0: return attach(factory.makeNull());
+                    case 0xc2: return attach(factory.makeBoolean(False));
+                    case 0xc3: return attach(factory.makeBoolean(True));
+                    case 0xca: return number(float32(big(4)));
+                    case 0xcb: return number(float64(big(8)));
+                    case 0xcc:
+                    case 0xcd:
+                    case 0xce:
+                    case 0xcf: return number(big(1 << (c - 0xcc)));
+                    case 0xd0:
+                    case 0xd1:
+                    case 0xd2:
+                    case 0xd3:
+                    {
+                        // sign extended from the top bit of its width
+                        const auto n = 1 << (c - 0xd0);
+                        const auto u = big(n);
+                        const auto shift = 64 - 8 * n;
+                        return number(static_cast<std::int64_t>(u << shift) >> shift);
+                    }
+                    case 0xd9:
+                    case 0xda:
+                    case 0xdb: return attach(factory.makeLiteral(factory.copyLiteral(bytes(big(1 << (c - 0xd9))))));
+                    case 0xdc: return open(false, count(big(2)));
+                    case 0xdd: return open(false, count(big(4)));
+                    case 0xde: return open(true, count(big(2)));
+                    case 0xdf: return open(true, count(big(4)));
+                    default: malformed(c >= 0xc4 && c <= 0xc6 ? "binary data has no json form" : c == 0xc1 ? "reserved type" : "extension types have no json form");
+                }
+            }
+        };
+
+        template<typename option_t>
+        struct document_reader;
+
+        // document::parse(begin, end, f) decodes CBOR or MessagePack, containers are sized from their counts and
+        // literals copied into the arena
+        template<>
+        struct document_reader<binary_format> {
+            template<typename document_t>
+            static document_t & read(document_t & d, const char * begin, const char * end, binary_format f) {
+                d.clear();
+                d.r = binary_parser<typename document_t::definition_t, typename document_t::factory_t>::parse(f, begin, end, d.factory());
+                return d;
+            }
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,385 @@
+
+#ifndef HEADER_JSON_PARSER_COMPACT
+#define HEADER_JSON_PARSER_COMPACT 1
+
+#include <new>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <typeinfo>
+#include <stdexcept>
+#include <string_view>
+
+#include "definition.hpp"
+
+namespace json {
+
+    namespace details {
+
+        // 16 byte tagged value, scalars and literals of up to 15 chars are stored inline,
+        // objects, arrays and longer literals own a single heap allocation
+        template<
+            template<typename, typename, typename...> typename object_t_,
+            template<typename, typename...> typename array_t_,
+            typename number_t_,
+            typename literal_t_,
+            typename ostream_t_
+        >
+        struct compact_definition {
+
+            struct value_t;
+            struct object_t;
+            struct array_t;
+
+            using number_t = number_t_;
+            using literal_t = literal_t_;
+            using var_t = value_t;
+            using primitive_t = value_t;
+
+            static_assert(sizeof(number_t) <= 8, "compact number type has to fit in 8 bytes");
+
+            struct alignas(8) value_t {
+                using type_t = value_type;
+
+                value_t() noexcept { tag(tag_t::null); }
+                value_t(decltype(nullptr)) noexcept : value_t() {}
+                value_t(json::boolean b) noexcept { store(b); tag(tag_t::boolean); }
+                value_t(number_t n) noexcept { store(n); tag(tag_t::number); }
+                value_t(std::string_view l) { assignLiteral(l); }
+                value_t(const char * l) : value_t(std::string_view(l)) {}
+                value_t(const literal_t & l) : value_t(std::string_view(l.data(), l.size())) {}
+                value_t(object_t o) { store(new object_t(std::move(o))); tag(tag_t::object); }
+                value_t(array_t a) { store(new array_t(std::move(a))); tag(tag_t::array); }
+
+                value_t(const value_t & c) : value_t() { *this = c; }
+                value_t(value_t && m) noexcept {
+                    std::memcpy(raw, m.raw, sizeof(raw));
+                    m.tag(tag_t::null);
+                }
+                ~value_t() { destroy(); }
+
+                value_t & operator=(const value_t & c) {
+                    if (this == &c) { return *this; }
+                    value_t t;
+                    switch (c.tag()) {
+                        case tag_t::heap_literal: t.assignLiteral(c.literal()); break;
+                        case tag_t::object: t.store(new object_t(*c.template load<object_t *>())); t.tag(tag_t::object); break;
+                        case tag_t::array: t.store(new array_t(*c.template load<array_t *>())); t.tag(tag_t::array); break;
+                        default: std::memcpy(t.raw, c.raw, sizeof(raw)); break;
+                    }
+                    return *this = std::move(t);
+                }
+
+                value_t & operator=(value_t && m) noexcept {
+                    if (this != &m) {
+                        destroy();
+                        std::memcpy(raw, m.raw, sizeof(raw));
+                        m.tag(tag_t::null);
+                    }
+                    return *this;
+                }
+
+                type_t type() const noexcept {
+                    switch (tag()) {
+                        case tag_t::boolean: return type_t::boolean;
+                        case tag_t::number:
+                        case tag_t::integer:
+                        case tag_t::uinteger: return type_t::number;
+                        case tag_t::inline_literal:
+                        case tag_t::heap_literal: return type_t::literal;
+                        case tag_t::object: return type_t::object;
+                        case tag_t::array: return type_t::array;
+                        default: return type_t::null;
+                    }
+                }
+
+                bool isNull() const noexcept { return tag() == tag_t::null; }
+                bool isObject() const noexcept { return tag() == tag_t::object; }
+                bool isArray() const noexcept { return tag() == tag_t::array; }
+                bool isPrimitive() const noexcept { return tag() < tag_t::object; }
+
+                object_t * tryAsObject() noexcept { return isObject() ? load<object_t *>() : nullptr; }
+                const object_t * tryAsObject() const noexcept { return isObject() ? load<object_t *>() : nullptr; }
+                object_t & asObject() { return *checked(tryAsObject()); }
+                const object_t & asObject() const { return *checked(tryAsObject()); }
+
+                array_t * tryAsArray() noexcept { return isArray() ? load<array_t *>() : nullptr; }
+                const array_t * tryAsArray() const noexcept { return isArray() ? load<array_t *>() : nullptr; }
+                array_t & asArray() { return *checked(tryAsArray()); }
+                const array_t & asArray() const { return *checked(tryAsArray()); }
+
+                value_t * tryAsPrimitive() noexcept { return isPrimitive() ? this : nullptr; }
+                const value_t * tryAsPrimitive() const noexcept { return isPrimitive() ? this : nullptr; }
+                value_t & asPrimitive() { return *checked(tryAsPrimitive()); }
+                const value_t & asPrimitive() const { return *checked(tryAsPrimitive()); }
+
+                number_t number() const {
+                    switch (tag()) {
+                        case tag_t::number: return load<number_t>();
+                        case tag_t::integer: return static_cast<number_t>(load<std::int64_t>());
+                        case tag_t::uinteger: return static_cast<number_t>(load<std::uint64_t>());
+                        default: throw std::bad_cast();
+                    }
+                }
+
+                // exact integers, only produced by fromInteger()/fromUnsigned() or a parse with parse_options::exactIntegers
+                static value_t fromInteger(std::int64_t i) noexcept {
+                    value_t r;
+                    r.store(i);
+                    r.tag(tag_t::integer);
+                    return r;
+                }
+
+                static value_t fromUnsigned(std::uint64_t u) noexcept {
+                    if (u <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) { return fromInteger(static_cast<std::int64_t>(u)); }
+                    value_t r;
+                    r.store(u);
+                    r.tag(tag_t::uinteger);
+                    return r;
+                }
+
+                bool isInteger() const noexcept { return tag() == tag_t::integer || tag() == tag_t::uinteger; }
+
+                std::int64_t integer() const {
+                    if (tag() == tag_t::uinteger) { throw std::range_error("json number out of range"); }
+                    if (tag() != tag_t::integer) { throw std::bad_cast(); }
+                    return load<std::int64_t>();
+                }
+
+                std::uint64_t uinteger() const {
+                    if (tag() == tag_t::uinteger) { return load<std::uint64_t>(); }
+                    if (tag() != tag_t::integer) { throw std::bad_cast(); }
+                    const auto i = load<std::int64_t>();
+                    if (i < 0) { throw std::range_error("json number out of range"); }
+                    return static_cast<std::uint64_t>(i);
+                }
+
+                json::boolean boolean() const {
+                    if (tag() != tag_t::boolean) { throw std::bad_cast(); }
+                    return load<json::boolean>();
+                }
+
+                std::string_view literal() const {
+                    switch (tag()) {
+                        case tag_t::inline_literal: return { reinterpret_cast<const char *>(raw), static_cast<std::size_t>(raw[15] >> 4) };
+                        case tag_t::heap_literal: return { load<const char *>(), static_cast<std::size_t>(load<std::uint32_t, 8>()) };
+                        default: throw std::bad_cast();
+                    }
+                }
+
+                void write(writer & w, int indent = -1, int layer = 0) const {
+                    switch (tag()) {
+                        case tag_t::boolean: w.boolean(static_cast<bool>(load<json::boolean>())); break;
+                        case tag_t::number: w.number(load<number_t>()); break;
+                        case tag_t::integer: w.number(load<std::int64_t>()); break;
+                        case tag_t::uinteger: w.number(load<std::uint64_t>()); break;
+                        case tag_t::inline_literal:
+                        case tag_t::heap_literal: w.literal(literal()); break;
+                        case tag_t::object: load<object_t *>()->write(w, indent, layer); break;
+                        case tag_t::array: load<array_t *>()->write(w, indent, layer); break;
+                        default: w.null(); break;
+                    }
+                }
+
+                void print(ostream_t_ & s, int indent = -1, int layer = 0) const {
+                    writer w{ &writeToStream<ostream_t_>, &s };
+                    write(w, indent, layer);
+                    w.flush();
+                }
+
+                bool operator==(const value_t & v) const {
+                    if (tag() == v.tag()) {
+                        switch (tag()) {
+                            case tag_t::null: return true;
+                            case tag_t::boolean: return load<json::boolean>() == v.template load<json::boolean>();
+                            case tag_t::number: return *this == v.template load<number_t>();
+                            case tag_t::integer:
+                            case tag_t::uinteger: return load<std::uint64_t>() == v.template load<std::uint64_t>();
+                            case tag_t::object: return *load<object_t *>() == *v.template load<object_t *>();
+                            case tag_t::array: return *load<array_t *>() == *v.template load<array_t *>();
+                            default: break;
+                        }
+                    }
+                    if (isInteger() && v.isInteger()) { return false; }
+                    if (type() == type_t::number && v.type() == type_t::number) { return *this == v.number(); }
+                    return type() == type_t::literal && v.type() == type_t::literal && literal() == v.literal();
+                }
+
+                bool operator==(decltype(nullptr)) const noexcept { return isNull(); }
+                bool operator==(json::boolean b) const noexcept { return tag() == tag_t::boolean && load<json::boolean>() == b; }
+                bool operator==(number_t n) const noexcept {
+                    return type() == type_t::number && compare_primitive<number_t, std::numeric_limits<number_t>::is_specialized>::equal(n, number());
+                }
+                bool operator==(std::string_view l) const noexcept { return type() == type_t::literal && literal() == l; }
+                bool operator==(const char * l) const noexcept { return *this == std::string_view(l); }
+
+                template<typename x>
+                bool operator!=(const x & v) const { return !(*this == v); }
+
+                // literals up to this length are stored inline
+                static constexpr std::size_t inlineCapacity = 15;
+
+            private:
+
+                enum struct tag_t : unsigned char { null, boolean, number, integer, uinteger, inline_literal, heap_literal, object, array };
+
+                // bytes [0, 15) hold the payload, the low nibble of byte 15 is the tag and the high nibble the inline literal length
+                unsigned char raw[16];
+
+                tag_t tag() const noexcept { return static_cast<tag_t>(raw[15] & 0x0f); }
+                void tag(tag_t t, std::size_t inlineLength = 0) noexcept { raw[15] = static_cast<unsigned char>(static_cast<unsigned char>(t) | (inlineLength << 4)); }
+
+                template<typename x, std::size_t offset = 0>
+                x load() const noexcept {
+                    x r;
+                    std::memcpy(&r, raw + offset, sizeof(x));
+                    return r;
+                }
+
+                template<typename x, std::size_t offset = 0>
+                void store(x v) noexcept { std::memcpy(raw + offset, &v, sizeof(x)); }
+
+                template<typename x>
+                static x * checked(x * p) {
+                    if (p == nullptr) { throw std::bad_cast(); }
+                    return p;
+                }
+
+                void assignLiteral(std::string_view l) {
+                    if (l.size() <= inlineCapacity) {
+                        if (!l.empty()) { std::memcpy(raw, l.data(), l.size()); }
+                        tag(tag_t::inline_literal, l.size());
+                        return;
+                    }
+                    if (l.size() > std::numeric_limits<std::uint32_t>::max()) { throw std::length_error("json literal too long"); }
+                    auto d = new char[l.size()];
+                    std::memcpy(d, l.data(), l.size());
+                    store<char *>(d);
+                    store<std::uint32_t, 8>(static_cast<std::uint32_t>(l.size()));
+                    tag(tag_t::heap_literal);
+                }
+
+                void destroy() noexcept {
+                    switch (tag()) {
+                        case tag_t::heap_literal: delete[] load<char *>(); break;
+                        case tag_t::object: delete load<object_t *>(); break;
+                        case tag_t::array: delete load<array_t *>(); break;
+                        default: break;
+                    }
+                }
+
+            };
+
+            static_assert(sizeof(value_t) == 16, "compact value has to be 16 bytes");
+
+            struct object_t : object_t_<literal_t, value_t> {
+                using base_t = object_t_<literal_t, value_t>;
+
+                template<typename ... args_t>
+                explicit object_t(args_t && ... args) : base_t(std::forward<args_t>(args)...) {}
+
+                void write(writer & w, int indent = -1, int layer = 0) const {
+                    w.container('{', '}', this->begin(), this->end(), indent, layer, [&](const auto & i) {
+                        w.key(i.first, indent);
+                        i.second.write(w, indent, layer + 1);
+                    });
+                }
+
+                template<typename literal_t__>
+                object_t & set(literal_t__ key, value_t value) {
+                    this->operator[](std::move(key)) = std::move(value);
+                    return *this;
+                }
+
+            };
+
+            struct array_t : array_t_<value_t> {
+                using base_t = array_t_<value_t>;
+
+                template<typename ... args_t>
+                explicit array_t(args_t && ... args) : base_t(std::forward<args_t>(args)...) {}
+
+                void write(writer & w, int indent = -1, int layer = 0) const {
+                    w.container('[', ']', this->begin(), this->end(), indent, layer, [&](const auto & i) {
+                        i.write(w, indent, layer + 1);
+                    });
+                }
+
+                array_t & add(value_t value) {
+                    this->emplace_back(std::move(value));
+                    return *this;
+                }
+
+            };
+
+        };
+
+        // builds compact values, containers are reached through the value tag instead of a vtable
+        template<typename definition_t>
+        struct compact_factory {
+            using value_t = typename definition_t::value_t;
+            using object_t = typename definition_t::object_t;
+            using array_t = typename definition_t::array_t;
+            using number_t = typename definition_t::number_t;
+            using literal_t = typename definition_t::literal_t;
+            using key_t = literal_t;
+
+            // scalars and short literals are stored inline, only containers and longer literals allocate
+            value_t makeNull(parse_stats * = nullptr) noexcept { return {}; }
+            value_t makeBoolean(json::boolean b, parse_stats * = nullptr) noexcept { return b; }
+            value_t makeNumber(const number_token & n, parse_stats * = nullptr) {
+                if (exactIntegers) {
+                    switch (n.kind) {
+                        case number_token::kind_t::integer: return value_t::fromInteger(n.i);
+                        case number_token::kind_t::uinteger: return value_t::fromUnsigned(n.u);
+                        default: break;
+                    }
+                }
+                return n.template as<number_t>();
+            }
+            value_t makeLiteral(literal_t && l, parse_stats * stats = nullptr) {
+                if (stats != nullptr && l.size() > value_t::inlineCapacity) { ++stats->allocations; }
+                return value_t(l);
+            }
+            value_t makeObject(parse_stats * stats = nullptr) {
+                if (stats != nullptr) { ++stats->allocations; }
+                return object_t();
+            }
+            value_t makeArray(parse_stats * stats = nullptr) {
+                if (stats != nullptr) { ++stats->allocations; }
+                return array_t();
+            }
+
+            static object_t * tryAsObject(value_t & v) noexcept { return v.tryAsObject(); }
+            static array_t * tryAsArray(value_t & v) noexcept { return v.tryAsArray(); }
+
+            static void set(object_t & o, literal_t && k, value_t && v) { objectSet(o, std::move(k), std::move(v)); }
+            static void close(object_t & o) { objectClose(o); }
+            static void add(array_t & a, value_t && v) { a.emplace_back(std::move(v)); }
+            static void reserve(object_t & o, std::size_t n) { containerReserve(o, n); }
+            static void reserve(array_t & a, std::size_t n) { containerReserve(a, n); }
+
+            literal_t literal() { return {}; }
+
+            // the decoded literal only allocates once it outgrows the string's own small buffer
+            literal_t readLiteral(const char *& p, const char * e, parse_stats * stats = nullptr) {
+                literal_t l;
+                const auto small = l.capacity();
+                details::readLiteral(p, e, l, stats);
+                if (stats != nullptr && l.capacity() > small) { ++stats->allocations; }
+                return l;
+            }
+
+            key_t readKey(const char *& p, const char * e, parse_stats * stats = nullptr) { return readLiteral(p, e, stats); }
+
+            literal_t copyLiteral(std::string_view v) { return literal_t(v.data(), v.size()); }
+            key_t copyKey(std::string_view v) { return copyLiteral(v); }
+
+            bool exactIntegers = false;
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,284 @@
+
+#ifndef HEADER_JSON_PARSER_CONTAINERS
+#define HEADER_JSON_PARSER_CONTAINERS 1
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+namespace json {
+    namespace details {
+
+        // hashes string-like keys through std::string_view, so keys with any allocator hash alike
+        template<typename key_t>
+        struct key_hash {
+            std::size_t operator()(const key_t & k) const noexcept {
+                if constexpr (std::is_constructible<std::string_view, decltype(k.data()), decltype(k.size())>::value) {
+                    return std::hash<std::string_view>()(std::string_view(k.data(), k.size()));
+                } else {
+                    return std::hash<key_t>()(k);
+                }
+            }
+        };
+
+        // map over a vector kept sorted by key, lookups are binary searches over contiguous storage;
+        // append() followed by finish() builds it with a single sort
+        template<
+            typename key_t,
+            typename mapped_t,
+            typename compare_t = std::less<key_t>,
+            typename allocator_t = std::allocator<std::pair<key_t, mapped_t>>
+        >
+        struct flat_map {
+            using key_type = key_t;
+            using mapped_type = mapped_t;
+            using value_type = std::pair<key_t, mapped_t>;
+            using allocator_type = allocator_t;
+            using storage_t = std::vector<value_type, allocator_t>;
+            using size_type = std::size_t;
+            using iterator = typename storage_t::iterator;
+            using const_iterator = typename storage_t::const_iterator;
+
+            flat_map() = default;
+            explicit flat_map(const allocator_t & a) : v(a) {}
+
+            iterator begin() noexcept { return v.begin(); }
+            iterator end() noexcept { return v.end(); }
+            const_iterator begin() const noexcept { return v.begin(); }
+            const_iterator end() const noexcept { return v.end(); }
+
+            size_type size() const noexcept { return v.size(); }
+            bool empty() const noexcept { return v.empty(); }
+            void clear() noexcept { v.clear(); }
+            void reserve(size_type n) { v.reserve(n); }
+
+            iterator find(const key_t & k) {
+                const auto i = lowerBound(k);
+                return i != v.end() && !compare_t()(k, i->first) ? i : v.end();
+            }
+
+            const_iterator find(const key_t & k) const { return const_cast<flat_map &>(*this).find(k); }
+
+            size_type count(const key_t & k) const { return find(k) != end() ? 1 : 0; }
+
+            mapped_t & at(const key_t & k) {
+                const auto i = find(k);
+                if (i == v.end()) { throw std::out_of_range("flat_map::at"); }
+                return i->second;
+            }
+
+            const mapped_t & at(const key_t & k) const { return const_cast<flat_map &>(*this).at(k); }
+
+            mapped_t & operator[](key_t k) { return emplace(std::move(k), mapped_t()).first->second; }
+
+            std::pair<iterator, bool> emplace(key_t k, mapped_t m) {
+                const auto i = lowerBound(k);
+                if (i != v.end() && !compare_t()(k, i->first)) { return { i, false }; }
+                return { v.emplace(i, std::move(k), std::move(m)), true };
+            }
+
+            size_type erase(const key_t & k) {
+                const auto i = find(k);
+                if (i == v.end()) { return 0; }
+                v.erase(i);
+                return 1;
+            }
+
+            iterator erase(const_iterator i) { return v.erase(i); }
+
+            // bulk build, a later duplicate replaces an earlier one as with operator[]
+            void append(key_t k, mapped_t m) { v.emplace_back(std::move(k), std::move(m)); }
+
+            void finish() {
+                const auto less = [](const value_type & a, const value_type & b) { return compare_t()(a.first, b.first); };
+                if (v.size() <= 16) {
+                    // stable insertion sort, most objects are short
+                    for (auto i = v.begin() + (v.empty() ? 0 : 1); i != v.end(); ++i) {
+                        if (!less(*i, *(i - 1))) { continue; }
+                        auto t = std::move(*i);
+                        auto j = i;
+                        do {
+                            *j = std::move(*(j - 1));
+                            --j;
+                        } while (j != v.begin() && less(t, *(j - 1)));
+                        *j = std::move(t);
+                    }
+                } else if (!std::is_sorted(v.begin(), v.end(), less)) {
+                    // sorts positions and moves every entry once, ties keep document order
+                    std::vector<std::size_t> order(v.size());
+                    for (std::size_t i = 0; i < order.size(); ++i) { order[i] = i; }
+                    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return less(v[a], v[b]) || (!less(v[b], v[a]) && a < b); });
+                    storage_t sorted(v.get_allocator());
+                    sorted.reserve(v.size());
+                    for (const auto i : order) { sorted.push_back(std::move(v[i])); }
+                    v.swap(sorted);
+                }
+                auto w = v.begin();
+                for (auto r = v.begin(); r != v.end();) {
+                    auto n = r + 1;
+                    while (n != v.end() && !compare_t()(r->first, n->first)) { r = n++; }
+                    if (w != r) { *w = std::move(*r); }
+                    ++w;
+                    r = n;
+                }
+                v.erase(w, v.end());
+            }
+
+            bool operator==(const flat_map & o) const { return v == o.v; }
+            bool operator!=(const flat_map & o) const { return !(v == o.v); }
+
+        private:
+            storage_t v;
+
+            iterator lowerBound(const key_t & k) {
+                return std::lower_bound(v.begin(), v.end(), k, [](const value_type & a, const key_t & b) { return compare_t()(a.first, b); });
+            }
+        };
+
+        // open-addressing index over a dense vector of entries, iterates in insertion order;
+        // a slot holds 32 bits of the hash over the entry position + 1, 0 marks an empty slot
+        template<
+            typename key_t,
+            typename mapped_t,
+            typename hash_t = key_hash<key_t>,
+            typename equal_t = std::equal_to<key_t>,
+            typename allocator_t = std::allocator<std::pair<key_t, mapped_t>>
+        >
+        struct hash_map {
+            using key_type = key_t;
+            using mapped_type = mapped_t;
+            using value_type = std::pair<key_t, mapped_t>;
+            using allocator_type = allocator_t;
+            using storage_t = std::vector<value_type, allocator_t>;
+            using slots_t = std::vector<std::uint64_t, typename std::allocator_traits<allocator_t>::template rebind_alloc<std::uint64_t>>;
+            using size_type = std::size_t;
+            using iterator = typename storage_t::iterator;
+            using const_iterator = typename storage_t::const_iterator;
+
+            hash_map() = default;
+            explicit hash_map(const allocator_t & a) : v(a), slots(a) {}
+
+            iterator begin() noexcept { return v.begin(); }
+            iterator end() noexcept { return v.end(); }
+            const_iterator begin() const noexcept { return v.begin(); }
+            const_iterator end() const noexcept { return v.end(); }
+
+            size_type size() const noexcept { return v.size(); }
+            bool empty() const noexcept { return v.empty(); }
+
+            void clear() noexcept {
+                v.clear();
+                slots.clear();
+            }
+
+            void reserve(size_type n) {
+                v.reserve(n);
+                if (capacityFor(n) > slots.size()) { rehash(capacityFor(n)); }
+            }
+
+            iterator find(const key_t & k) {
+                if (v.empty()) { return v.end(); }
+                const auto h = hash(k);
+                for (auto i = static_cast<std::size_t>(h);; ++i) {
+                    const auto s = slots[i & (slots.size() - 1)];
+                    if (s == 0) { return v.end(); }
+                    if ((s >> 32) == (h >> 32) && equal_t()(v[(s & 0xffffffffu) - 1].first, k)) { return v.begin() + static_cast<std::ptrdiff_t>((s & 0xffffffffu) - 1); }
+                }
+            }
+
+            const_iterator find(const key_t & k) const { return const_cast<hash_map &>(*this).find(k); }
+
+            size_type count(const key_t & k) const { return find(k) != end() ? 1 : 0; }
+
+            mapped_t & at(const key_t & k) {
+                const auto i = find(k);
+                if (i == v.end()) { throw std::out_of_range("hash_map::at"); }
+                return i->second;
+            }
+
+            const mapped_t & at(const key_t & k) const { return const_cast<hash_map &>(*this).at(k); }
+
+            mapped_t & operator[](key_t k) { return emplace(std::move(k), mapped_t()).first->second; }
+
+            std::pair<iterator, bool> emplace(key_t k, mapped_t m) {
+                const auto i = find(k);
+                if (i != v.end()) { return { i, false }; }
+                if (v.size() >= 0xffffffffu) { throw std::length_error("hash_map too large"); }
+                if (capacityFor(v.size() + 1) > slots.size()) { rehash(capacityFor(v.size() + 1) * 2); }
+                v.emplace_back(std::move(k), std::move(m));
+                place(hash(v.back().first), v.size());
+                return { v.end() - 1, true };
+            }
+
+            // keeps insertion order, linear in size
+            size_type erase(const key_t & k) {
+                const auto i = find(k);
+                if (i == v.end()) { return 0; }
+                v.erase(i);
+                rehash(slots.size());
+                return 1;
+            }
+
+            iterator erase(const_iterator i) {
+                const auto n = i - v.cbegin();
+                v.erase(i);
+                rehash(slots.size());
+                return v.begin() + n;
+            }
+
+            // same members regardless of order
+            bool operator==(const hash_map & o) const {
+                if (v.size() != o.v.size()) { return false; }
+                for (const auto & e : v) {
+                    const auto i = o.find(e.first);
+                    if (i == o.end() || !(i->second == e.second)) { return false; }
+                }
+                return true;
+            }
+
+            bool operator!=(const hash_map & o) const { return !operator==(o); }
+
+        private:
+            storage_t v;
+            slots_t slots;
+
+            // slots for n entries at a load factor of at most 3/4
+            static size_type capacityFor(size_type n) noexcept {
+                size_type c = 8;
+                while (c * 3 < n * 4) { c *= 2; }
+                return c;
+            }
+
+            static std::uint64_t hash(const key_t & k) noexcept {
+                const auto h = static_cast<std::uint64_t>(hash_t()(k));
+                // the high half is compared in slots, the low half picks the slot
+                return (h << 32) | ((h >> 32) ^ (h & 0xffffffffu));
+            }
+
+            void place(std::uint64_t h, size_type position) noexcept {
+                for (auto i = static_cast<std::size_t>(h);; ++i) {
+                    auto & s = slots[i & (slots.size() - 1)];
+                    if (s == 0) {
+                        s = (h & 0xffffffff00000000u) | position;
+                        return;
+                    }
+                }
+            }
+
+            void rehash(size_type n) {
+                slots.assign(n, 0);
+                for (size_type i = 0; i < v.size(); ++i) { place(hash(v[i].first), i + 1); }
+            }
+        };
+
+    }
+}
+
+#endif
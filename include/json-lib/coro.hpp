@@ -0,0 +1,169 @@
+
+#ifndef HEADER_JSON_PARSER_CORO
+#define HEADER_JSON_PARSER_CORO 1
+
+// coroutine entry points are compiled only where the compiler implements C++20 coroutines
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#   if __has_include(<coroutine>)
+#       define JSON_LIB_COROUTINES 1
+#   endif
+#endif
+
+#if defined(JSON_LIB_COROUTINES)
+
+#include <string>
+#include <cstddef>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <stdexcept>
+#include <coroutine>
+
+#include "push.hpp"
+#include "writer.hpp"
+
+namespace json {
+    namespace details {
+
+        template<typename x>
+        struct task;
+
+        template<typename x>
+        struct task_promise_base {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            // resumes the awaiting coroutine, if any, when the body is finished
+            struct final_awaiter {
+                bool await_ready() const noexcept { return false; }
+
+                template<typename promise_t>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_t> h) noexcept {
+                    const auto c = h.promise().continuation;
+                    return c ? c : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            final_awaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        template<typename x>
+        struct task_promise : task_promise_base<x> {
+            std::optional<x> value;
+
+            task<x> get_return_object() noexcept;
+            void return_value(x v) { value.emplace(std::move(v)); }
+
+            x result() {
+                if (this->error) { std::rethrow_exception(this->error); }
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct task_promise<void> : task_promise_base<void> {
+            task<void> get_return_object() noexcept;
+            void return_void() const noexcept {}
+
+            void result() const {
+                if (error) { std::rethrow_exception(error); }
+            }
+        };
+
+        // lazily started coroutine, co_await runs it and resumes the awaiter with its result once it finishes;
+        // a task that is not awaited is run by start() and polled with done(), suspended work is resumed by
+        // whatever the awaited sources and sinks hand their coroutine handles to
+        template<typename x>
+        struct task {
+            using promise_type = task_promise<x>;
+            using handle_t = std::coroutine_handle<promise_type>;
+
+            explicit task(handle_t h) noexcept : h(h) {}
+            task(task && t) noexcept : h(std::exchange(t.h, nullptr)) {}
+
+            task & operator=(task && t) noexcept {
+                if (this != &t) {
+                    if (h) { h.destroy(); }
+                    h = std::exchange(t.h, nullptr);
+                }
+                return *this;
+            }
+
+            task(const task &) = delete;
+            task & operator=(const task &) = delete;
+
+            ~task() {
+                if (h) { h.destroy(); }
+            }
+
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> c) noexcept {
+                h.promise().continuation = c;
+                return h;
+            }
+
+            x await_resume() { return h.promise().result(); }
+
+            // runs the task up to its first suspension
+            void start() { h.resume(); }
+
+            bool done() const noexcept { return h.done(); }
+
+            // the value of a finished task, rethrows what it threw
+            x result() {
+                if (!h.done()) { throw std::logic_error("json task not finished"); }
+                return h.promise().result();
+            }
+
+        private:
+            handle_t h;
+        };
+
+        template<typename x>
+        inline task<x> task_promise<x>::get_return_object() noexcept { return task<x>{ std::coroutine_handle<task_promise<x>>::from_promise(*this) }; }
+
+        inline task<void> task_promise<void>::get_return_object() noexcept { return task<void>{ std::coroutine_handle<task_promise<void>>::from_promise(*this) }; }
+
+        // parses one document from source.read(char *, std::size_t), an awaitable yielding the bytes read, 0 at the end;
+        // each chunk goes through a push_parser, so the coroutine only suspends in the source;
+        // bytes of the last chunk after the document are dropped
+        template<typename push_parser_t, typename source_t>
+        inline task<typename push_parser_t::value_t> asyncParse(source_t & source, std::size_t chunkSize) {
+            push_parser_t p;
+            std::string chunk(chunkSize > 0 ? chunkSize : 1, '\0');
+            for (;;) {
+                const std::size_t n = co_await source.read(&chunk[0], chunk.size());
+                if (n == 0) {
+                    p.finish();
+                    co_return p.take();
+                }
+                if (p.feed(chunk.data(), n) == push_status::done) { co_return p.take(); }
+            }
+        }
+
+        // serializes v and hands the text to sink.write(const char *, std::size_t), an awaitable yielding the bytes taken,
+        // in chunks of up to chunkSize; the text is built before the first write
+        template<typename value_t, typename sink_t>
+        inline task<void> asyncWrite(const value_t & v, sink_t & sink, int indent, std::size_t chunkSize) {
+            writer w;
+            v.write(w, indent);
+            const auto text = w.release();
+            if (chunkSize == 0) { chunkSize = 1; }
+            for (std::size_t i = 0; i < text.size();) {
+                const std::size_t n = co_await sink.write(text.data() + i, text.size() - i < chunkSize ? text.size() - i : chunkSize);
+                if (n == 0) { throw std::runtime_error("failed to write json"); }
+                i += n;
+            }
+        }
+
+    }
+}
+
+#endif
+
+#endif
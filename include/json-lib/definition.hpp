@@ -3,18 +3,35 @@
 #define HEADER_JSON_PARSER_DFINITION 1
 
 #include <new>
+#include <ios>
+#include <istream>
 #include <limits>
 #include <vector>
-#include <cuchar>
-#include <climits>
+#include <cstdint>
+#include <string>
+#include <cstring>
 #include <utility>
+#include <string_view>
 #include <algorithm>
+#include <type_traits>
 #include <stdexcept>
 
+#include "scan.hpp"
+#include "number.hpp"
+#include "writer.hpp"
+#include "stats.hpp"
+
 namespace json {
 
     enum boolean : bool { False = false, True = true };
 
+    enum struct value_type : unsigned char { null, number, literal, boolean, object, array };
+
+    struct parse_options {
+        // keep integers as exact int64_t/uint64_t, for definitions that can store them (json::compact)
+        bool exactIntegers = false;
+    };
+
     namespace details {
 
         template<typename char_t>
@@ -23,29 +40,99 @@ namespace json {
         template<typename char_t>
         inline static bool isDigit(char_t c) noexcept { return c >= '0' && c <= '9'; }
 
-        template<typename istream_t>
-        inline static auto streamPeek(istream_t & s) -> decltype(s.peek()) {
-            auto v = s.peek();
-            if (v == istream_t::traits_type::eof()) { throw std::runtime_error("failed to read json"); }
-            return v;
+        template<typename char_t>
+        inline static char_t bufferPeek(const char_t * p, const char_t * e) {
+            if (p == e) { throw std::runtime_error("failed to read json"); }
+            return *p;
+        }
+
+        template<typename char_t>
+        inline static char_t bufferGet(const char_t *& p, const char_t * e) {
+            if (p == e) { throw std::runtime_error("failed to read json"); }
+            return *p++;
+        }
+
+        inline static void skipWhitespaces(const char *& p, const char * e) noexcept { p = scanWhitespaces(p, e); }
+
+        inline static void readWord(const char *& p, const char * e, const char * w, std::size_t n) {
+            if (static_cast<std::size_t>(e - p) < n || std::memcmp(p, w, n) != 0) { throw std::runtime_error("failed to parse json"); }
+            p += n;
         }
 
-        template<typename istream_t, typename int_t>
-        inline static auto streamGet(istream_t & s, int_t & charsRead) -> decltype(s.get()) {
-            auto v = s.get();
-            if (v == istream_t::traits_type::eof()) { throw std::runtime_error("failed to read json"); }
-            charsRead += 1;
-            return v;
+        // raw literal text is checked to be UTF-8 only when JSON_LIB_VALIDATE_UTF8 is defined
+        inline static void checkUtf8(const char * p, const char * e) {
+#if defined(JSON_LIB_VALIDATE_UTF8)
+            if (!isValidUtf8(p, e)) { throw std::runtime_error("failed to parse json: illegal utf-8 sequence"); }
+#else
+            static_cast<void>(p);
+            static_cast<void>(e);
+#endif
+        }
+
+        inline static std::uint32_t readHex4(const char *& p, const char * e) {
+            std::uint32_t r = 0;
+            for (int i = 0; i < 4; ++i) {
+                const auto d = static_cast<unsigned char>(bufferGet(p, e));
+                if (d >= '0' && d <= '9') {
+                    r = r * 16 + (d - '0');
+                } else if ((d | 0x20) >= 'a' && (d | 0x20) <= 'f') {
+                    r = r * 16 + ((d | 0x20) - 'a' + 10);
+                } else {
+                    throw std::runtime_error("failed to parse json: illegal escape character");
+                }
+            }
+            return r;
+        }
+
+        // reads the code point of a \u escape, p is past the 'u'; a high surrogate has to be followed by an escaped low one
+        inline static std::uint32_t readCodePoint(const char *& p, const char * e) {
+            const auto u = readHex4(p, e);
+            if (u < 0xd800 || u >= 0xe000) { return u; }
+            if (u >= 0xdc00 || bufferGet(p, e) != '\\' || bufferGet(p, e) != 'u') { throw std::runtime_error("failed to parse json: unpaired utf-16 surrogate"); }
+            const auto l = readHex4(p, e);
+            if (l < 0xdc00 || l >= 0xe000) { throw std::runtime_error("failed to parse json: unpaired utf-16 surrogate"); }
+            return 0x10000 + ((u - 0xd800) << 10) + (l - 0xdc00);
+        }
+
+        // writes the UTF-8 form of code point u to b, returns its length
+        inline static std::size_t encodeUtf8(std::uint32_t u, char * b) noexcept {
+            if (u < 0x80) {
+                b[0] = static_cast<char>(u);
+                return 1;
+            }
+            if (u < 0x800) {
+                b[0] = static_cast<char>(0xc0 | (u >> 6));
+                b[1] = static_cast<char>(0x80 | (u & 0x3f));
+                return 2;
+            }
+            if (u < 0x10000) {
+                b[0] = static_cast<char>(0xe0 | (u >> 12));
+                b[1] = static_cast<char>(0x80 | ((u >> 6) & 0x3f));
+                b[2] = static_cast<char>(0x80 | (u & 0x3f));
+                return 3;
+            }
+            b[0] = static_cast<char>(0xf0 | (u >> 18));
+            b[1] = static_cast<char>(0x80 | ((u >> 12) & 0x3f));
+            b[2] = static_cast<char>(0x80 | ((u >> 6) & 0x3f));
+            b[3] = static_cast<char>(0x80 | (u & 0x3f));
+            return 4;
         }
 
-        template<typename istream_t, typename literal_t, typename int_t>
-        inline static void readLiteral(istream_t & s, literal_t & r, int_t & charsRead) {
-            if (streamGet(s, charsRead) != '"') { throw std::runtime_error("failed to parse json"); }
-            bool esc = false;
-            for (auto c = streamPeek(s);; c = streamPeek(s)) {
-                streamGet(s, charsRead);
-                if (esc) {
-                    switch (c) {
+        // reads the rest of a literal, p is past the opening quote; escapes are counted into stats when given
+        template<typename literal_t>
+        inline static void readLiteralTail(const char *& p, const char * e, literal_t & r, parse_stats * stats = nullptr) {
+            for (;;) {
+                {
+                    auto q = scanLiteral(p, e);
+                    checkUtf8(p, q);
+                    if (q != p) { r.append(p, static_cast<std::size_t>(q - p)); }
+                    p = q;
+                }
+                auto c = bufferGet(p, e);
+                if (c == '"') { break; }
+                if (c == '\\') {
+                    if (stats != nullptr) { ++stats->escapes; }
+                    switch (bufferGet(p, e)) {
                         case '"': r.append("\""); break;
                         case '\\': r.append("\\"); break;
                         case '/': r.append("/"); break;
@@ -56,56 +143,170 @@ namespace json {
                         case 't': r.append("\t"); break;
                         case 'u':
                         {
-                            union {
-                                char b[4];
-                                char32_t e;
-                            };
-                            static_assert(sizeof(char32_t) == (sizeof(char) * 4), "unexpected char32_t size");
-                            for (int i = 0; i < 4; ++i) {
-                                auto d = b[i] = streamGet(s, charsRead);
-                                if (!((d >= '0' && d <= '9') || (d >= 'a' && d <= 'f') || (d >= 'A' && d <= 'F'))) {
-                                    throw std::runtime_error("failed to parse json: illegal escape character");
-                                }
-                            }
-                            std::mbstate_t state{};
-                            char buf[MB_LEN_MAX]{};
-                            if (std::c32rtomb(buf, e, &state) == -1) { throw std::runtime_error("failed to parse json: illegal u32 character"); }
-                            r.append(buf);
+                            char b[4];
+                            r.append(b, encodeUtf8(readCodePoint(p, e), b));
                             break;
                         }
                         default: throw std::runtime_error("failed to parse json: illegal escape character");
                     }
-                    esc = false;
                     continue;
                 }
-                if (c == '\\') { esc = true; continue; }
-                if (c == '"') { break; }
-                {
-                    char b[2];
-                    b[0] = c;
-                    b[1] = 0;
-                    r.append(b);
+                throw std::runtime_error("failed to parse json: illegal control character");
+            }
+        }
+
+        // the read functions add the decoded bytes and escapes to stats when given
+        template<typename literal_t>
+        inline static void readLiteral(const char *& p, const char * e, literal_t & r, parse_stats * stats = nullptr) {
+            if (bufferGet(p, e) != '"') { throw std::runtime_error("failed to parse json"); }
+            readLiteralTail(p, e, r, stats);
+            if (stats != nullptr) { stats->literalBytes += r.size(); }
+        }
+
+        // a literal without escapes is returned as a view into [p, e), otherwise it is decoded into scratch
+        inline static std::string_view readLiteralView(const char *& p, const char * e, std::string & scratch, parse_stats * stats = nullptr) {
+            if (bufferGet(p, e) != '"') { throw std::runtime_error("failed to parse json"); }
+            const auto q = scanLiteral(p, e);
+            checkUtf8(p, q);
+            if (q != e && *q == '"') {
+                const std::string_view v(p, static_cast<std::size_t>(q - p));
+                p = q + 1;
+                if (stats != nullptr) { stats->literalBytes += v.size(); }
+                return v;
+            }
+            scratch.assign(p, q);
+            p = q;
+            readLiteralTail(p, e, scratch, stats);
+            if (stats != nullptr) { stats->literalBytes += scratch.size(); }
+            return scratch;
+        }
+
+        // appends by moving text towards the front of the buffer it is read from
+        struct insitu_literal {
+            char * w;
+
+            void append(const char * d, std::size_t n) noexcept {
+                std::memmove(w, d, n);
+                w += n;
+            }
+
+            void append(const char * d) noexcept { append(d, std::strlen(d)); }
+        };
+
+        // decodes a literal in place and returns a view of it, the text at p has to be writable,
+        // the decoded text is never longer than the escaped one
+        inline static std::string_view readLiteralInSitu(const char *& p, const char * e, parse_stats * stats = nullptr) {
+            if (bufferGet(p, e) != '"') { throw std::runtime_error("failed to parse json"); }
+            const auto b = const_cast<char *>(p);
+            const auto q = scanLiteral(p, e);
+            checkUtf8(p, q);
+            auto w = const_cast<char *>(q);
+            if (q != e && *q == '"') {
+                p = q + 1;
+            } else {
+                insitu_literal r{ w };
+                p = q;
+                readLiteralTail(p, e, r, stats);
+                w = r.w;
+            }
+            if (stats != nullptr) { stats->literalBytes += static_cast<std::size_t>(w - b); }
+            return { b, static_cast<std::size_t>(w - b) };
+        }
+
+        // returns the position past the closing quote, or nullptr if [p, e) ends first;
+        // escaped tells whether p follows a backslash and is updated for the next range
+        inline static const char * literalEnd(const char * p, const char * e, bool & escaped) noexcept {
+            for (;;) {
+                if (escaped) {
+                    if (p == e) { return nullptr; }
+                    ++p;
+                    escaped = false;
                 }
+                p = scanLiteral(p, e);
+                if (p == e) { return nullptr; }
+                if (*p++ == '"') { return p; }
+                if (p[-1] == '\\') { escaped = true; }
             }
         }
 
-        template<typename ostream_t, typename literal_t>
-        inline static void writeLiteral(ostream_t & s, const literal_t & l) {
-            s << '\"';
-            for (auto c : l) {
-                switch (c) {
-                    case '"': s << "\\\""; break;
-                    case '\\': s << "\\\\"; break;
-                    case '/': s << "\\/"; break;
-                    case '\b': s << "\\b"; break;
-                    case '\f': s << "\\f"; break;
-                    case '\n': s << "\\n"; break;
-                    case '\r': s << "\\r"; break;
-                    case '\t': s << "\\t"; break;
-                    default: s << c;
+        // numbers and words end at whitespace or a separator, nullptr if [p, e) ends first
+        inline static const char * scalarEnd(const char * p, const char * e) noexcept {
+            while (p != e && !isWhitespaceByte(static_cast<unsigned char>(*p)) && !isStructuralByte(static_cast<unsigned char>(*p)) && *p != ',' && *p != ':') { ++p; }
+            return p != e ? p : nullptr;
+        }
+
+        // follows a value through its text in one or more ranges, as a whole buffer or a byte at a time: feed() returns
+        // the position past the value, or nullptr once the range is used up with the value still open; only strings and
+        // brackets are inspected, a scalar ends at the next separator, which is not part of it
+        struct value_scanner {
+            std::size_t depth = 0;
+            bool started = false;
+            bool scalar = false;
+            bool literal = false;
+            bool escaped = false;
+
+            const char * feed(const char * p, const char * e) noexcept {
+                if (!started) {
+                    if (p == e) { return nullptr; }
+                    started = true;
+                    switch (*p) {
+                        case '"': literal = true; ++p; break;
+                        case '{':
+                        case '[': depth = 1; ++p; break;
+                        default: scalar = true;
+                    }
+                }
+                if (scalar) { return scalarEnd(p, e); }
+                for (;;) {
+                    if (literal) {
+                        if ((p = literalEnd(p, e, escaped)) == nullptr) { return nullptr; }
+                        literal = false;
+                        if (depth == 0) { return p; }
+                    }
+                    p = scanStructural(p, e);
+                    if (p == e) { return nullptr; }
+                    switch (*p++) {
+                        case '"': literal = true; break;
+                        case '{':
+                        case '[': ++depth; break;
+                        default: if (--depth == 0) { return p; }
+                    }
+                }
+            }
+        };
+
+        // returns the position past the value at p, or nullptr if [p, e) ends first, see value_scanner
+        inline static const char * valueEnd(const char * p, const char * e) noexcept { return value_scanner{}.feed(p, e); }
+
+        // reads s up to the end of its first value through its stream buffer, leading whitespace skipped; bytes are
+        // fed to a value_scanner one at a time so that nothing past the value leaves s and a pipe is never waited on
+        // for more than the value, a value ending the stream sets eofbit
+        template<typename istream_t>
+        inline static std::string readValue(istream_t & s) {
+            using traits_t = typename istream_t::traits_type;
+            std::string r;
+            const typename std::basic_istream<typename istream_t::char_type, traits_t>::sentry ok{ s, true };
+            if (!ok) { return r; }
+            const auto b = s.rdbuf();
+            value_scanner v;
+            for (auto i = b->sgetc();; i = b->sgetc()) {
+                if (traits_t::eq_int_type(i, traits_t::eof())) {
+                    s.setstate(std::ios_base::eofbit);
+                    break;
+                }
+                const auto c = traits_t::to_char_type(i);
+                if (r.empty() && isWhitespaceByte(static_cast<unsigned char>(c))) {
+                    b->sbumpc();
+                    continue;
                 }
+                // a scalar ends before the byte that is not part of it, which is left in s
+                const auto l = v.feed(&c, &c + 1);
+                if (l == &c) { break; }
+                r.push_back(c);
+                b->sbumpc();
+                if (l != nullptr) { break; }
             }
-            s << '\"';
+            return r;
         }
 
         template<typename x, bool numericLimitsSpecialized>
@@ -232,7 +433,8 @@ namespace json {
             template<typename, typename...> typename array_t_,
             typename number_t_,
             typename literal_t_,
-            typename ostream_t_
+            typename ostream_t_,
+            typename key_t_ = literal_t_
         >
         struct definition {
 
@@ -243,6 +445,7 @@ namespace json {
 
             using number_t = number_t_;
             using literal_t = literal_t_;
+            using key_t = key_t_;
 
             struct var_t {
                 using ptr_t = uptr_t_<var_t>;
@@ -251,10 +454,6 @@ namespace json {
             protected:
                 var_t() = default;
 
-                static void writeIndent0(ostream_t_ & s, int indent) {
-                    for (int i = 0; i < indent; ++i) { s << ' '; }
-                }
-
             public:
                 virtual bool isObject() const noexcept { return false; }
                 virtual object_t * tryAsObject() noexcept { return nullptr; }
@@ -274,7 +473,13 @@ namespace json {
                 virtual primitive_t & asPrimitive() { throw std::bad_cast(); }
                 virtual const primitive_t & asPrimitive() const { throw std::bad_cast(); }
 
-                virtual void print(ostream_t_ & s, int indent = -1, int layer = 0) const = 0;
+                virtual void write(writer & w, int indent = -1, int layer = 0) const = 0;
+
+                void print(ostream_t_ & s, int indent = -1, int layer = 0) const {
+                    writer w{ &writeToStream<ostream_t_>, &s };
+                    write(w, indent, layer);
+                    w.flush();
+                }
 
                 virtual bool operator==(const var_t &) const { return false; }
                 virtual bool operator==(decltype(nullptr)) const { return false; }
@@ -296,9 +501,9 @@ namespace json {
 
             };
 
-            struct object_t : var_t, object_t_<literal_t, uptr_t_<var_t>> {
+            struct object_t : var_t, object_t_<key_t, uptr_t_<var_t>> {
                 using ptr_t = uptr_t_<object_t>;
-                using base_t = object_t_<literal_t, uptr_t_<var_t>>;
+                using base_t = object_t_<key_t, uptr_t_<var_t>>;
 
                 template<typename ... args_t>
                 explicit object_t(args_t && ... args) : base_t(std::forward<args_t>(args)...) {}
@@ -309,34 +514,15 @@ namespace json {
                 virtual object_t & asObject() noexcept override { return *this; }
                 virtual const object_t & asObject() const noexcept override { return *this; }
 
-                virtual void print(ostream_t_ & s, int indent = -1, int layer = 0) const override {
-                    s << '{';
-                    if (!this->empty()) {
-                        if (indent >= 0) {
-                            s << "\n";
-                            this->writeIndent0(s, indent * (layer + 1));
-                        }
-                        for (auto i = this->begin(), l = this->end();;) {
-                            writeLiteral(s, i->first);
-                            s << (indent >= 0 ? ": " : ":");
-                            if (i->second) {
-                                i->second->print(s, indent, layer + 1);
-                            } else {
-                                primitive_t().print(s, indent, layer + 1);
-                            }
-                            ++i;
-                            if (i != l) { s << ","; } else { break; }
-                            if (indent >= 0) {
-                                s << "\n";
-                                this->writeIndent0(s, indent * (layer + 1));
-                            }
-                        }
-                        if (indent >= 0) {
-                            s << "\n";
-                            this->writeIndent0(s, indent * layer);
+                virtual void write(writer & w, int indent = -1, int layer = 0) const override {
+                    w.container('{', '}', this->begin(), this->end(), indent, layer, [&](const auto & i) {
+                        w.key(i.first, indent);
+                        if (i.second) {
+                            i.second->write(w, indent, layer + 1);
+                        } else {
+                            w.null();
                         }
-                    }
-                    s << '}';
+                    });
                 }
 
                 template<typename literal_t__>
@@ -365,32 +551,14 @@ namespace json {
                 virtual array_t & asArray() noexcept override { return *this; }
                 virtual const array_t & asArray() const noexcept override { return *this; }
 
-                virtual void print(ostream_t_ & s, int indent = -1, int layer = 0) const override {
-                    s << '[';
-                    if (!this->empty()) {
-                        if (indent >= 0) {
-                            s << "\n";
-                            this->writeIndent0(s, indent * (layer + 1));
+                virtual void write(writer & w, int indent = -1, int layer = 0) const override {
+                    w.container('[', ']', this->begin(), this->end(), indent, layer, [&](const auto & i) {
+                        if (i) {
+                            i->write(w, indent, layer + 1);
+                        } else {
+                            w.null();
                         }
-                        for (auto i = this->begin(), l = this->end();;) {
-                            if (*i) {
-                                (**i).print(s, indent, layer + 1);
-                            } else {
-                                primitive_t().print(s, indent, layer + 1);
-                            }
-                            ++i;
-                            if (i != l) { s << ","; } else { break; }
-                            if (indent >= 0) {
-                                s << "\n";
-                                this->writeIndent0(s, indent * (layer + 1));
-                            }
-                        }
-                        if (indent >= 0) {
-                            s << "\n";
-                            this->writeIndent0(s, indent * layer);
-                        }
-                    }
-                    s << ']';
+                    });
                 }
 
                 array_t & add(typename var_t::ptr_t value) {
@@ -418,12 +586,12 @@ namespace json {
                 virtual primitive_t & asPrimitive() noexcept override { return *this; }
                 virtual const primitive_t & asPrimitive() const noexcept override { return *this; }
 
-                virtual void print(ostream_t_ & s, int indent = -1, int layer = 0) const override {
+                virtual void write(writer & w, int = -1, int = 0) const override {
                     switch (this->type()) {
-                        case type_t::number: s << this->number(); break;
-                        case type_t::literal: writeLiteral(s, this->literal()); break;
-                        case type_t::boolean: s << (static_cast<bool>(this->boolean()) ? "true" : "false"); break;
-                        default: s << "null"; break;
+                        case type_t::number: w.number(this->number()); break;
+                        case type_t::literal: w.literal(this->literal()); break;
+                        case type_t::boolean: w.boolean(static_cast<bool>(this->boolean())); break;
+                        default: w.null(); break;
                     }
                 }
 
@@ -443,225 +611,445 @@ namespace json {
 
         };
 
-        template<typename definition_t_, typename istream_t_>
-        struct parser {
+        // builds pointer trees of a definition, derived_t provides node allocation and literals
+        // object containers with append() and finish() are filled unsorted and ordered once when the object is closed
+        template<typename object_t, typename = void>
+        struct bulk_object : std::false_type {};
 
-            using istream_t = istream_t_;
-            using definition_t = definition_t_;
+        template<typename object_t>
+        struct bulk_object<object_t, std::void_t<decltype(std::declval<object_t &>().finish())>> : std::true_type {};
+
+        template<typename object_t, typename literal_t, typename value_t>
+        inline static void objectSet(object_t & o, literal_t && k, value_t && v) {
+            if constexpr (bulk_object<object_t>::value) {
+                o.append(std::move(k), std::move(v));
+            } else {
+                o[std::move(k)] = std::move(v);
+            }
+        }
+
+        template<typename object_t>
+        inline static void objectClose(object_t & o) {
+            if constexpr (bulk_object<object_t>::value) { o.finish(); }
+        }
+
+        template<typename container_t, typename = void>
+        struct reservable : std::false_type {};
+
+        template<typename container_t>
+        struct reservable<container_t, std::void_t<decltype(std::declval<container_t &>().reserve(std::size_t()))>> : std::true_type {};
 
-            using var_t = typename definition_t::var_t;
+        // sizes a container up front where it can be, others grow as they are filled
+        template<typename container_t>
+        inline static void containerReserve(container_t & c, std::size_t n) {
+            if constexpr (reservable<container_t>::value) { c.reserve(n); }
+        }
+
+        template<typename definition_t, typename derived_t>
+        struct tree_factory {
+            using value_t = typename definition_t::var_t::ptr_t;
             using object_t = typename definition_t::object_t;
             using array_t = typename definition_t::array_t;
             using primitive_t = typename definition_t::primitive_t;
             using number_t = typename definition_t::number_t;
             using literal_t = typename definition_t::literal_t;
+            using key_t = typename definition_t::key_t;
+
+            // every node is an allocation of its own
+            value_t makeNull(parse_stats * stats = nullptr) { return node<primitive_t>(stats, nullptr); }
+            value_t makeBoolean(json::boolean b, parse_stats * stats = nullptr) { return node<primitive_t>(stats, b); }
+            value_t makeNumber(const number_token & n, parse_stats * stats = nullptr) { return node<primitive_t>(stats, n.template as<number_t>()); }
+            value_t makeLiteral(literal_t && l, parse_stats * stats = nullptr) { return node<primitive_t>(stats, std::move(l)); }
+            value_t makeObject(parse_stats * stats = nullptr) { return node<object_t>(stats); }
+            value_t makeArray(parse_stats * stats = nullptr) { return node<array_t>(stats); }
+
+            static object_t * tryAsObject(value_t & v) noexcept { return v ? v->tryAsObject() : nullptr; }
+            static array_t * tryAsArray(value_t & v) noexcept { return v ? v->tryAsArray() : nullptr; }
+
+            static void set(object_t & o, key_t && k, value_t && v) { objectSet(o, std::move(k), std::move(v)); }
+            static void close(object_t & o) { objectClose(o); }
+            static void add(array_t & a, value_t && v) { a.emplace_back(std::move(v)); }
+            static void reserve(object_t & o, std::size_t n) { containerReserve(o, n); }
+            static void reserve(array_t & a, std::size_t n) { containerReserve(a, n); }
+
+            // a copy of the literal, counted as an allocation
+            literal_t readLiteral(const char *& p, const char * e, parse_stats * stats = nullptr) {
+                auto l = self().literal();
+                details::readLiteral(p, e, l, stats);
+                if (stats != nullptr) { ++stats->allocations; }
+                return l;
+            }
 
-            std::vector<void(parser:: *)(void)> exe_stack;
-            std::vector<typename var_t::ptr_t> var_stack;
-            istream_t * s = nullptr;
-            long long charsRead = 0;
+            key_t readKey(const char *& p, const char * e, parse_stats * stats = nullptr) { return self().readLiteral(p, e, stats); }
 
-            parser(istream_t * s) : s(s) {}
-            ~parser() = default;
+            // literals and keys that are already decoded, from binary formats
+            literal_t copyLiteral(std::string_view v) {
+                auto l = self().literal();
+                l.append(v.data(), v.size());
+                return l;
+            }
 
-            auto streamPeek() -> decltype(details::streamPeek(*s)) { return details::streamPeek(*s); }
+            key_t copyKey(std::string_view v) { return self().copyLiteral(v); }
 
-            auto streamGet() -> decltype(details::streamGet(*s, charsRead)) { return details::streamGet(*s, charsRead); }
+        private:
+            derived_t & self() noexcept { return static_cast<derived_t &>(*this); }
 
-            number_t readJsonNumber() {
-                bool neg = false;
-                if (streamPeek() == '-') {
-                    streamGet();
-                    neg = true;
-                }
-                if (!isDigit(streamPeek())) { throw std::runtime_error("failed to parse json"); }
-                number_t n = 0, o = 0;
-                while (true) {
-                    auto c = streamPeek();
-                    if (isDigit(c)) {
-                        n = (n * 10) + (((number_t)c) - ((number_t)'0'));
-                    } else if (c == '.') {
-                        streamGet();
-                        for (number_t m = 1;; m *= 10) {
-                            c = streamPeek();
-                            if (isDigit(c)) {
-                                o += o * 10 + (((number_t)c) - ((number_t)'0'));
-                            /*} else if (c == '.') {
-                                throw std::runtime_error("failed to parse json");*/
-                            } else {
-                                n += o / m;
-                                break;
-                            }
-                            streamGet();
-                        }
-                        break;
-                    } else {
-                        break;
-                    }
-                    streamGet();
-                }
-                return neg ? -n : n;
+            template<typename x, typename ... args_t>
+            value_t node(parse_stats * stats, args_t && ... args) {
+                if (stats != nullptr) { ++stats->allocations; }
+                return self().template make<x>(std::forward<args_t>(args)...);
+            }
+        };
+
+        template<typename definition_t>
+        struct heap_factory : tree_factory<definition_t, heap_factory<definition_t>> {
+            template<typename x, typename ... args_t>
+            x * make(args_t && ... args) { return new x(std::forward<args_t>(args)...); }
+
+            typename definition_t::literal_t literal() { return {}; }
+        };
+
+        // the json grammar, non-recursive with one byte of state per nesting level; a handler is told about every token
+        // and returns false to stop, strings are read by the handler from their opening quote; stats_t is told about
+        // every value before it is read and about a literal or key once the handler has read it, see no_stats and
+        // limits_checker
+        template<typename stats_t_ = no_stats>
+        struct reader {
+
+            using stats_t = stats_t_;
+
+            enum struct state_t : unsigned char { value, first, next, key, colon, done };
+            enum struct scope_t : unsigned char { object, array };
+
+            std::vector<scope_t> scopes;
+            state_t state = state_t::value;
+            const char * begin = nullptr;
+            const char * s = nullptr;
+            const char * end = nullptr;
+            stats_t stats;
+
+            reader(const char * begin, const char * end, stats_t stats = {}) : begin(begin), s(begin), end(end), stats(std::move(stats)) {}
+
+            long long charsRead() const noexcept { return static_cast<long long>(s - begin); }
+
+            bool done() const noexcept { return state == state_t::done; }
+
+            // starts over on [b, e), the stack keeps its capacity
+            void reset(const char * b, const char * e) noexcept {
+                begin = s = b;
+                end = e;
+                scopes.clear();
+                state = state_t::value;
+            }
+
+            // reads the value at the current position, false if the handler stopped;
+            // the reader is left past the last character consumed
+            template<typename handler_t>
+            bool read(handler_t & h) {
+                state = state_t::value;
+                return run<false>(h, false);
+            }
+
+            // as read(), telling stats_t that a document starts and ends there
+            template<typename handler_t>
+            bool readDocument(handler_t & h) {
+                stats.start(s);
+                const auto r = read(h);
+                stats.finish(s);
+                return r;
             }
 
-            void skipWhitespaces() {
-                for (auto c = streamPeek(); isWhitespace(c); c = streamPeek()) { streamGet(); }
+            // throws unless only whitespace is left before end, for a buffer that holds a single document
+            void expectEnd() {
+                skipWhitespaces(s, end);
+                if (s != end) { throw std::runtime_error("failed to parse json"); }
             }
 
-            void read() {
-                skipWhitespaces();
-                switch (streamPeek()) {
+            // continues the value with [s, end): stops at end between two tokens, or at the start of a token cut by end
+            // unless last says that it ends there; done() once the value is complete
+            template<typename handler_t>
+            bool resume(handler_t & h, bool last) { return run<true>(h, last); }
+
+        private:
 
-                    // object
-                    case '{': exe_stack.emplace_back(&parser::objStart); break;
+            // past the scalar or string at s, nullptr if it may continue after end
+            template<bool resumable>
+            const char * token(bool last) const noexcept {
+                if (!resumable || last) { return end; }
+                auto escaped = false;
+                return *s == '"' ? literalEnd(s + 1, end, escaped) : scalarEnd(s, end);
+            }
 
-                    // array
-                    case '[': exe_stack.emplace_back(&parser::arrStart); break;
+            // reads an opening bracket, a whole buffer is read on to close an empty container at once
+            template<bool resumable, bool object, typename handler_t>
+            bool open(handler_t & h) {
+                stats.value(s);
+                stats.container(s++, object, scopes.size() + 1);
+                if (!(object ? h.onObjectStart() : h.onArrayStart())) { return false; }
+                scopes.push_back(object ? scope_t::object : scope_t::array);
+                state = state_t::first;
+                if (resumable) { return true; }
+                skipWhitespaces(s, end);
+                return first<object>(h);
+            }
 
-                    // null
-                    case 'n':
-                    {
-                        if (streamGet() != 'n' || streamGet() != 'u' || streamGet() != 'l' || streamGet() != 'l') {
-                            throw std::runtime_error("failed to parse json");
+            // the first token after an opening bracket and whitespace
+            template<bool object, typename handler_t>
+            bool first(handler_t & h) {
+                if (bufferPeek(s, end) != (object ? '}' : ']')) {
+                    state = object ? state_t::key : state_t::value;
+                    return true;
+                }
+                ++s;
+                scopes.pop_back();
+                state = state_t::next;
+                return object ? h.onObjectEnd() : h.onArrayEnd();
+            }
+
+            template<bool resumable, typename handler_t>
+            bool run(handler_t & h, bool last) {
+                for (;;) {
+                    switch (state) {
+
+                        case state_t::value:
+                        {
+                            skipWhitespaces(s, end);
+                            if (resumable && s == end) { return true; }
+                            const auto c = bufferPeek(s, end);
+                            if (c == '{') {
+                                if (!open<resumable, true>(h)) { return false; }
+                                continue;
+                            }
+                            if (c == '[') {
+                                if (!open<resumable, false>(h)) { return false; }
+                                continue;
+                            }
+                            const auto t = token<resumable>(last);
+                            if (t == nullptr) { return true; }
+                            stats.value(s);
+                            switch (c) {
+                                case 'n':
+                                {
+                                    readWord(s, t, "null", 4);
+                                    if (!h.onNull()) { return false; }
+                                    stats.null();
+                                    break;
+                                }
+                                case 't':
+                                {
+                                    readWord(s, t, "true", 4);
+                                    if (!h.onBoolean(true)) { return false; }
+                                    stats.boolean();
+                                    break;
+                                }
+                                case 'f':
+                                {
+                                    readWord(s, t, "false", 5);
+                                    if (!h.onBoolean(false)) { return false; }
+                                    stats.boolean();
+                                    break;
+                                }
+                                case '"':
+                                {
+                                    const auto b = s;
+                                    if (!h.onString(s, t)) { return false; }
+                                    stats.literal(b, s);
+                                    break;
+                                }
+                                default:
+                                {
+                                    if (!h.onNumber(readJsonNumber(s, t))) { return false; }
+                                    stats.number();
+                                }
+                            }
+                            if (resumable && s != t) { throw std::runtime_error("failed to parse json"); }
+                            state = state_t::next;
+                            continue;
                         }
-                        var_stack.emplace_back(new primitive_t(nullptr));
-                        break;
-                    }
 
-                    // true
-                    case 't':
-                    {
-                        if (streamGet() != 't' || streamGet() != 'r' || streamGet() != 'u' || streamGet() != 'e') {
-                            throw std::runtime_error("failed to parse json");
+                        case state_t::first:
+                        {
+                            skipWhitespaces(s, end);
+                            if (resumable && s == end) { return true; }
+                            if (!(scopes.back() == scope_t::object ? first<true>(h) : first<false>(h))) { return false; }
+                            continue;
+                        }
+
+                        case state_t::next:
+                        {
+                            if (scopes.empty()) {
+                                state = state_t::done;
+                                return true;
+                            }
+                            skipWhitespaces(s, end);
+                            if (resumable && s == end) { return true; }
+                            const auto c = bufferGet(s, end);
+                            const auto object = scopes.back() == scope_t::object;
+                            if (c == ',') {
+                                state = object ? state_t::key : state_t::value;
+                                continue;
+                            }
+                            if (c != (object ? '}' : ']')) { throw std::runtime_error("failed to parse json"); }
+                            scopes.pop_back();
+                            if (!(object ? h.onObjectEnd() : h.onArrayEnd())) { return false; }
+                            continue;
                         }
-                        var_stack.emplace_back(new primitive_t(True));
-                        break;
-                    }
 
-                    // true
-                    case 'f':
-                    {
-                        if (streamGet() != 'f' || streamGet() != 'a' || streamGet() != 'l' || streamGet() != 's' || streamGet() != 'e') {
-                            throw std::runtime_error("failed to parse json");
+                        case state_t::key:
+                        {
+                            skipWhitespaces(s, end);
+                            if (resumable && s == end) { return true; }
+                            if (bufferPeek(s, end) != '"') { throw std::runtime_error("failed to parse json"); }
+                            const auto t = token<resumable>(last);
+                            if (t == nullptr) { return true; }
+                            const auto b = s;
+                            if (!h.onKey(s, t)) { return false; }
+                            stats.key(b, s);
+                            if (resumable && s != t) { throw std::runtime_error("failed to parse json"); }
+                            state = state_t::colon;
+                            if (resumable) { continue; }
+                            skipWhitespaces(s, end);
+                            if (bufferGet(s, end) != ':') { throw std::runtime_error("failed to parse json"); }
+                            state = state_t::value;
+                            continue;
                         }
-                        var_stack.emplace_back(new primitive_t(False));
-                        break;
-                    }
 
-                    // literal
-                    case '"':
-                    {
-                        literal_t l;
-                        readLiteral(*s, l, charsRead);
-                        var_stack.emplace_back(new primitive_t(std::move(l)));
-                        break;
-                    }
+                        case state_t::colon:
+                        {
+                            skipWhitespaces(s, end);
+                            if (resumable && s == end) { return true; }
+                            if (bufferGet(s, end) != ':') { throw std::runtime_error("failed to parse json"); }
+                            state = state_t::value;
+                            continue;
+                        }
+
+                        case state_t::done: return true;
 
-                    default:
-                    {
-                        auto n = readJsonNumber();
-                        var_stack.emplace_back(new primitive_t(n));
                     }
                 }
             }
+        };
+
+        // builds values through a factory as the reader's handler; a container is attached to its parent when it is
+        // opened and filled through a direct reference, so values have to keep their container's address when moved
+        template<typename definition_t_, typename factory_t_ = heap_factory<definition_t_>, typename stats_t_ = no_stats>
+        struct parser : reader<stats_t_> {
+
+            using definition_t = definition_t_;
+            using factory_t = factory_t_;
+            using stats_t = stats_t_;
+            using reader_t = reader<stats_t>;
+
+            using value_t = typename factory_t::value_t;
+            using object_t = typename definition_t::object_t;
+            using array_t = typename definition_t::array_t;
+            using number_t = typename definition_t::number_t;
+            using literal_t = typename definition_t::literal_t;
+            using key_t = typename factory_t::key_t;
+
+            std::vector<object_t *> objects;
+            std::vector<array_t *> arrays;
+            value_t root;
+            key_t key;
+            factory_t factory;
+
+            parser(const char * begin, const char * end, factory_t factory = {}, stats_t stats = {}) : reader_t(begin, end, std::move(stats)), root(), key(), factory(std::move(factory)) {}
+            ~parser() = default;
+
+            // starts over on [b, e), the stacks keep their capacity
+            void reset(const char * b, const char * e) noexcept {
+                reader_t::reset(b, e);
+                objects.clear();
+                arrays.clear();
+            }
+
+            // parses the document at the current position and leaves the parser past it
+            value_t read() {
+                this->readDocument(*this);
+                return std::move(root);
+            }
 
-            void objStart() {
-                if (streamGet() != '{') { throw std::runtime_error("failed to parse json"); }
-                var_stack.emplace_back(new object_t());
-                exe_stack.emplace_back(&parser::objReadContent);
+            // as read() for a value inside a document read by others, see stats_t::fork
+            value_t readElement() {
+                reader_t::read(*this);
+                return std::move(root);
             }
 
-            void objReadContent() {
-                skipWhitespaces();
-                if (streamPeek() == '"') { // kv pair
-                    objReadKV();
-                    return;
+            // hands v to the innermost container, or makes it the root
+            void attach(value_t && v) {
+                if (this->scopes.empty()) {
+                    root = std::move(v);
+                } else if (this->scopes.back() == reader_t::scope_t::object) {
+                    factory.set(*objects.back(), std::move(key), std::move(v));
+                } else {
+                    factory.add(*arrays.back(), std::move(v));
                 }
-                objEnd();
             }
 
-            void objReadKV() {
-                if (streamPeek() != '"') { throw std::runtime_error("failed to parse json"); }
-                literal_t k;
-                readLiteral(*s, k, charsRead);
-                skipWhitespaces();
-                if (streamGet() != ':') { throw std::runtime_error("failed to parse json"); }
-                var_stack.emplace_back(new primitive_t(std::move(k)));
-                exe_stack.emplace_back(&parser::objContinueKV);
-                exe_stack.emplace_back(&parser::read);
+            bool onNull() {
+                attach(factory.makeNull(this->stats.counters()));
+                return true;
             }
 
-            void objContinueKV() {
-                { // collect previously read kv
-                    auto v = std::move(var_stack.back());
-                    var_stack.pop_back();
+            bool onBoolean(bool b) {
+                attach(factory.makeBoolean(b ? True : False, this->stats.counters()));
+                return true;
+            }
 
-                    {
-                        auto k0 = dynamic_cast<primitive_t *>(var_stack.back().get());
-                        if (k0 == nullptr || k0->type() != primitive_t::type_t::literal) { throw std::runtime_error("failed to parse json"); }
-                    }
-                    typename primitive_t::ptr_t k(static_cast<primitive_t *>(var_stack.back().release()));
-                    var_stack.pop_back();
+            bool onNumber(const number_token & n) {
+                attach(factory.makeNumber(n, this->stats.counters()));
+                return true;
+            }
 
-                    auto o = dynamic_cast<object_t *>(var_stack.back().get());
-                    if (o == nullptr) { throw std::runtime_error("failed to parse json"); }
-                    (*o)[std::move(k->literal())] = std::move(v);
-                }
-                skipWhitespaces();
-                if (streamPeek() == ',') {
-                    streamGet();
-                    skipWhitespaces();
-                    objReadKV();
-                } else {
-                    objEnd();
-                }
+            bool onString(const char *& p, const char * e) {
+                const auto c = this->stats.counters();
+                attach(factory.makeLiteral(factory.readLiteral(p, e, c), c));
+                return true;
             }
 
-            void objEnd() {
-                if (streamGet() != '}') { throw std::runtime_error("failed to parse json"); }
-                if (dynamic_cast<object_t *>(var_stack.back().get()) == nullptr) { throw std::runtime_error("failed to parse json"); }
+            bool onKey(const char *& p, const char * e) {
+                key = factory.readKey(p, e, this->stats.counters());
+                return true;
             }
 
-            void arrStart() {
-                if (streamGet() != '[') { throw std::runtime_error("failed to parse json"); }
-                var_stack.emplace_back(new array_t());
-                skipWhitespaces();
-                if (streamPeek() != ']') {
-                    exe_stack.emplace_back(&parser::arrReadElement);
-                } else {
-                    arrEnd();
-                }
+            bool onObjectStart() {
+                auto v = factory.makeObject(this->stats.counters());
+                const auto o = factory.tryAsObject(v);
+                attach(std::move(v));
+                objects.push_back(o);
+                return true;
             }
 
-            void arrReadElement() {
-                exe_stack.emplace_back(&parser::arrContinueElements);
-                exe_stack.emplace_back(&parser::read);
+            bool onObjectEnd() {
+                factory.close(*objects.back());
+                objects.pop_back();
+                return true;
             }
 
-            void arrContinueElements() {
-                {
-                    auto v = std::move(var_stack.back());
-                    var_stack.pop_back();
+            bool onArrayStart() {
+                auto v = factory.makeArray(this->stats.counters());
+                const auto a = factory.tryAsArray(v);
+                attach(std::move(v));
+                arrays.push_back(a);
+                return true;
+            }
 
-                    auto a = dynamic_cast<array_t *>(var_stack.back().get());
-                    if (a == nullptr) { throw std::runtime_error("failed to parse json"); }
-                    a->emplace_back(std::move(v));
-                }
-                skipWhitespaces();
-                if (streamPeek() == ',') {
-                    streamGet();
-                    skipWhitespaces();
-                    arrReadElement();
-                } else {
-                    arrEnd();
-                }
+            bool onArrayEnd() {
+                arrays.pop_back();
+                return true;
             }
 
-            void arrEnd() {
-                if (streamGet() != ']') { throw std::runtime_error("failed to parse json"); }
-                if (dynamic_cast<array_t *>(var_stack.back().get()) == nullptr) { throw std::runtime_error("failed to parse json"); }
+            // [begin, end) has to hold a single value, whitespace aside
+            static value_t parse(const char * begin, const char * end, factory_t factory = {}, stats_t stats = {}) {
+                parser p{ begin, end, std::move(factory), std::move(stats) };
+                auto r = p.read();
+                p.expectEnd();
+                return r;
             }
 
-            static typename var_t::ptr_t parse(istream_t & s) {
+            // one value of s, the stream is left past it, see readValue
+            template<typename istream_t>
+            static value_t parse(istream_t & s) {
                 struct reset_t {
                     istream_t & s;
                     typename istream_t::iostate e;
@@ -677,24 +1065,17 @@ namespace json {
 
                 } s_reset{ s };
 
-                parser p{ &s };
-
-                p.skipWhitespaces();
-                p.exe_stack.emplace_back(&parser::read);
-                while (!p.exe_stack.empty()) {
-                    auto f = p.exe_stack.back();
-                    p.exe_stack.pop_back();
-                    (p.*f)();
-                }
-                if (p.var_stack.size() != 1) { throw std::runtime_error("failed to parse json"); }
-
-                return std::move(p.var_stack[0]);
+                auto b = readValue(s);
+                return parse(b.data(), b.data() + b.size());
             }
 
         };
 
+        template<typename definition_t>
+        inline static auto parse(const char * begin, const char * end) { return parser<definition_t>::parse(begin, end); }
+
         template<typename definition_t, typename istream_t>
-        inline static auto parse(istream_t & s) { return parser<definition_t, istream_t>::parse(s); }
+        inline static auto parse(istream_t & s) { return parser<definition_t>::parse(s); }
 
     }
 }
@@ -0,0 +1,145 @@
+
+#ifndef HEADER_JSON_PARSER_FILE
+#define HEADER_JSON_PARSER_FILE 1
+
+#include <string>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#   define JSON_LIB_NO_MMAP 1
+#endif
+
+#if !defined(JSON_LIB_NO_MMAP)
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#endif
+
+#include "definition.hpp"
+#include "arena.hpp"
+
+namespace json {
+    namespace details {
+
+        // the whole content of a file, mapped privately with a sequential access hint where mmap is available,
+        // otherwise (or for pipes and other unsized files) read into memory; writable pages are copied on write only.
+        // the scanners never load past the end of their range, so the mapping needs no padding
+        struct mapped_file {
+
+            explicit mapped_file(const char * path, bool writable = false) {
+#if !defined(JSON_LIB_NO_MMAP)
+                const auto fd = ::open(path, O_RDONLY | O_CLOEXEC);
+                if (fd < 0) { throw std::runtime_error("failed to open json file"); }
+                struct stat st;
+                if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+                    const auto n = static_cast<std::size_t>(st.st_size);
+                    const auto m = ::mmap(nullptr, n, PROT_READ | (writable ? PROT_WRITE : 0), MAP_PRIVATE, fd, 0);
+                    if (m != MAP_FAILED) {
+                        ::madvise(m, n, MADV_SEQUENTIAL);
+                        ::madvise(m, n, MADV_WILLNEED);
+                        ::close(fd);
+                        p = static_cast<char *>(m);
+                        s = n;
+                        mapped = true;
+                        return;
+                    }
+                }
+                char chunk[1 << 16];
+                for (;;) {
+                    const auto got = ::read(fd, chunk, sizeof(chunk));
+                    if (got < 0) {
+                        ::close(fd);
+                        throw std::runtime_error("failed to read json file");
+                    }
+                    if (got == 0) { break; }
+                    buffer.append(chunk, static_cast<std::size_t>(got));
+                }
+                ::close(fd);
+#else
+                std::ifstream f{ path, std::ios::binary };
+                if (!f) { throw std::runtime_error("failed to open json file"); }
+                buffer.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+#endif
+                p = &buffer[0];
+                s = buffer.size();
+            }
+
+            explicit mapped_file(const std::string & path, bool writable = false) : mapped_file(path.c_str(), writable) {}
+
+            mapped_file(const mapped_file &) = delete;
+            mapped_file & operator=(const mapped_file &) = delete;
+
+            mapped_file(mapped_file && m) noexcept { swap(m); }
+
+            mapped_file & operator=(mapped_file && m) noexcept {
+                swap(m);
+                return *this;
+            }
+
+            ~mapped_file() {
+#if !defined(JSON_LIB_NO_MMAP)
+                if (mapped) { ::munmap(p, s); }
+#endif
+            }
+
+            char * data() noexcept { return p; }
+            const char * data() const noexcept { return p; }
+            std::size_t size() const noexcept { return s; }
+
+            // false when the content was read into memory instead
+            bool isMapped() const noexcept { return mapped; }
+
+        private:
+            char * p = nullptr;
+            std::size_t s = 0;
+            bool mapped = false;
+            std::string buffer;
+
+            void swap(mapped_file & m) noexcept {
+                // a read buffer moves with its string, short ones change address
+                const auto own = !mapped && p != nullptr;
+                const auto other = !m.mapped && m.p != nullptr;
+                buffer.swap(m.buffer);
+                std::swap(p, m.p);
+                std::swap(s, m.s);
+                std::swap(mapped, m.mapped);
+                if (own) { m.p = &m.buffer[0]; }
+                if (other) { p = &buffer[0]; }
+            }
+        };
+
+        // an arena document parsed in place from a mapped file, std::string_view literals refer to the mapping,
+        // which lives as long as the document; escaped literals are decoded into privately copied pages
+        template<typename definition_t>
+        struct file_document {
+
+            using ptr_t = typename document<definition_t>::ptr_t;
+
+            explicit file_document(const char * path) : f(path, true) { d.parseInSitu(f.data(), f.data() + f.size()); }
+
+            explicit file_document(const std::string & path) : file_document(path.c_str()) {}
+
+            // literals refer to the content, which may be a read buffer that changes address when moved
+            file_document(const file_document &) = delete;
+            file_document & operator=(const file_document &) = delete;
+
+            const ptr_t & root() const noexcept { return d.root(); }
+
+            std::size_t size() const noexcept { return f.size(); }
+
+            std::size_t bytesAllocated() const noexcept { return d.bytesAllocated(); }
+
+        private:
+            mapped_file f;
+            document<definition_t> d;
+        };
+
+    }
+}
+
+#endif
@@ -3,12 +3,29 @@
 #define HEADER_JSON_PARSER_JSON 1
 
 #include <map>
+#include <chrono>
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <string>
 #include <ostream>
+#include <utility>
+#include <string_view>
 
 #include "definition.hpp"
+#include "containers.hpp"
+#include "keys.hpp"
+#include "stream.hpp"
+#include "parallel.hpp"
+#include "file.hpp"
+#include "push.hpp"
+#include "coro.hpp"
+#include "arena.hpp"
+#include "binary.hpp"
+#include "compact.hpp"
+#include "sax.hpp"
+#include "lazy.hpp"
+#include "tape.hpp"
 
 namespace json {
 
@@ -37,9 +54,301 @@ namespace json {
     using L = literal;
     using B = boolean;
 
-    template<typename istream_t>
+    namespace details {
+        // the largest node of the default tree, what limits_checker estimates each value at
+        constexpr std::size_t nodeBytes = std::max({ sizeof(object), sizeof(array), sizeof(number), sizeof(literal), sizeof(primitive) });
+
+        using heap_checker = limits_checker<>;
+        using arena_checker = limits_checker<arena>;
+    }
+
+    template<typename istream_t, typename = decltype(std::declval<istream_t &>().rdbuf())>
     inline static typename var::ptr_t parse(istream_t & s) { return details::parse<definition, istream_t>(s); }
 
+    inline static typename var::ptr_t parse(const char * begin, const char * end) { return details::parse<definition>(begin, end); }
+
+    inline static typename var::ptr_t parse(std::string_view s) { return parse(s.data(), s.data() + s.size()); }
+
+    // as parse(), adding counters and the time taken to stats
+    inline static typename var::ptr_t parse(const char * begin, const char * end, parse_stats & stats) {
+        return details::parser<definition, details::heap_factory<definition>, details::stats_recorder>::parse(begin, end, {}, details::stats_recorder{ &stats });
+    }
+
+    inline static typename var::ptr_t parse(std::string_view s, parse_stats & stats) { return parse(s.data(), s.data() + s.size(), stats); }
+
+    // as parse(), throwing limit_error once the text or the tree exceeds limits; memory is estimated from the largest node
+    inline static typename var::ptr_t parse(const char * begin, const char * end, const parse_limits & limits) {
+        details::heap_checker::check(limits, begin, end);
+        return details::parser<definition, details::heap_factory<definition>, details::heap_checker>::parse(begin, end, {}, { limits, details::nodeBytes });
+    }
+
+    inline static typename var::ptr_t parse(std::string_view s, const parse_limits & limits) { return parse(s.data(), s.data() + s.size(), limits); }
+
+    // a large root array or object is split into ranges of elements parsed on worker threads, see details::split_parser
+    inline static typename var::ptr_t parse(const char * begin, const char * end, parallel_options o) { return details::split_parser<definition>::parse(begin, end, o); }
+
+    inline static typename var::ptr_t parse(std::string_view s, parallel_options o) { return parse(s.data(), s.data() + s.size(), o); }
+
+    // as parse(begin, end, o), the ranges are held to limits together as one document
+    inline static typename var::ptr_t parse(const char * begin, const char * end, parallel_options o, const parse_limits & limits) {
+        details::heap_checker::check(limits, begin, end);
+        return details::split_parser<definition, details::heap_factory<definition>, details::heap_checker>::parse(begin, end, o, {}, { limits, details::nodeBytes });
+    }
+
+    inline static typename var::ptr_t parse(std::string_view s, parallel_options o, const parse_limits & limits) { return parse(s.data(), s.data() + s.size(), o, limits); }
+
+    // whether s is well-formed UTF-8, checking a whole text covers every literal in it; define JSON_LIB_VALIDATE_UTF8
+    // to have the parsers check literals as they read them instead
+    inline static bool is_valid_utf8(std::string_view s) noexcept { return details::isValidUtf8(s.data(), s.data() + s.size()); }
+
+    // parses straight from the mapped file, the mapping is released on return
+    inline static typename var::ptr_t parse_file(const char * path) {
+        const details::mapped_file f{ path };
+        return parse(f.data(), f.data() + f.size());
+    }
+
+    inline static typename var::ptr_t parse_file(const std::string & path) { return parse_file(path.c_str()); }
+
+    // CBOR (RFC 8949) for the same trees, see details::binary_parser; encode() takes a node of any definition or a compact value
+    namespace cbor {
+        template<typename value_t>
+        inline static std::string encode(const value_t & v) {
+            details::binary_writer w{ binary_format::cbor };
+            details::writeBinary(w, v);
+            return std::move(w.out);
+        }
+
+        inline static typename var::ptr_t parse(const char * begin, const char * end) { return details::binary_parser<definition>::parse(binary_format::cbor, begin, end); }
+
+        inline static typename var::ptr_t parse(std::string_view s) { return parse(s.data(), s.data() + s.size()); }
+    }
+
+    // MessagePack, as cbor
+    namespace msgpack {
+        template<typename value_t>
+        inline static std::string encode(const value_t & v) {
+            details::binary_writer w{ binary_format::msgpack };
+            details::writeBinary(w, v);
+            return std::move(w.out);
+        }
+
+        inline static typename var::ptr_t parse(const char * begin, const char * end) { return details::binary_parser<definition>::parse(binary_format::msgpack, begin, end); }
+
+        inline static typename var::ptr_t parse(std::string_view s) { return parse(s.data(), s.data() + s.size()); }
+    }
+
+    // fed with chunks as they arrive, see details::push_parser
+    using push_parser = details::push_parser<definition>;
+
+    // as push_parser, throwing limit_error once a document exceeds limits; offsets count from the document's first chunk
+    struct bounded_push_parser : details::push_parser<definition, details::heap_factory<definition>, details::heap_checker> {
+        explicit bounded_push_parser(const parse_limits & limits) : push_parser({}, { limits, details::nodeBytes }) {}
+    };
+
+#if defined(JSON_LIB_COROUTINES)
+    // co_await-able parse and write for coroutine executors, suspending only in the source or sink
+    namespace async {
+        template<typename x>
+        using task = details::task<x>;
+
+        // source.read(char *, std::size_t) is awaitable and yields the bytes read, 0 at the end of the input
+        template<typename source_t>
+        inline task<typename var::ptr_t> parse(source_t & source, std::size_t chunkSize = 1 << 16) { return details::asyncParse<push_parser>(source, chunkSize); }
+
+        // sink.write(const char *, std::size_t) is awaitable and yields the bytes taken; v has to outlive the task
+        template<typename value_t, typename sink_t>
+        inline task<void> write(const value_t & v, sink_t & sink, int indent = -1, std::size_t chunkSize = details::writer::defaultChunkSize) { return details::asyncWrite(v, sink, indent, chunkSize); }
+    }
+#endif
+
+    // serializes v (a var, compact value or any definition's node) into one string
+    template<typename value_t>
+    inline static std::string to_string(const value_t & v, int indent = -1) {
+        details::writer w;
+        v.write(w, indent);
+        return w.release();
+    }
+
+    // as to_string(), adding counters and the time taken to stats
+    template<typename value_t>
+    inline static std::string to_string(const value_t & v, print_stats & stats, int indent = -1) {
+        const auto t0 = std::chrono::steady_clock::now();
+        details::writer w;
+        w.instrument(&stats);
+        v.write(w, indent);
+        stats.bytes += w.str().size();
+        ++stats.documents;
+        stats.time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0);
+        return w.release();
+    }
+
+    // serializes v through sink(const char *, std::size_t), called with chunks of details::writer::defaultChunkSize or more
+    template<typename value_t, typename sink_t>
+    inline static void write(const value_t & v, sink_t & sink, int indent = -1) {
+        details::writer w{ [](void * c, const char * d, std::size_t n) { (*static_cast<sink_t *>(c))(d, n); }, &sink };
+        v.write(w, indent);
+        w.flush();
+    }
+
+    // as write(), adding counters and the time taken to stats
+    template<typename value_t, typename sink_t>
+    inline static void write(const value_t & v, sink_t & sink, print_stats & stats, int indent = -1) {
+        const auto t0 = std::chrono::steady_clock::now();
+        details::writer w{ [](void * c, const char * d, std::size_t n) { (*static_cast<sink_t *>(c))(d, n); }, &sink };
+        w.instrument(&stats);
+        v.write(w, indent);
+        w.flush();
+        ++stats.documents;
+        stats.time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0);
+    }
+
+    // objects as a vector sorted by key, built with one sort per object
+    namespace flat {
+        using definition = details::definition<details::unique_ptr, details::flat_map, std::vector, double, std::string, std::ostream>;
+
+        using var = typename definition::var_t;
+        using object = typename definition::object_t;
+        using array = typename definition::array_t;
+        using primitive = typename definition::primitive_t;
+        using number = typename definition::number_t;
+        using literal = typename definition::literal_t;
+
+        template<typename istream_t, typename = decltype(std::declval<istream_t &>().rdbuf())>
+        inline static typename var::ptr_t parse(istream_t & s) { return details::parse<definition, istream_t>(s); }
+
+        inline static typename var::ptr_t parse(const char * begin, const char * end) { return details::parse<definition>(begin, end); }
+
+        inline static typename var::ptr_t parse(std::string_view s) { return parse(s.data(), s.data() + s.size()); }
+    }
+
+    // objects as an open-addressing hash index over entries kept in insertion order
+    namespace hashed {
+        using definition = details::definition<details::unique_ptr, details::hash_map, std::vector, double, std::string, std::ostream>;
+
+        using var = typename definition::var_t;
+        using object = typename definition::object_t;
+        using array = typename definition::array_t;
+        using primitive = typename definition::primitive_t;
+        using number = typename definition::number_t;
+        using literal = typename definition::literal_t;
+
+        template<typename istream_t, typename = decltype(std::declval<istream_t &>().rdbuf())>
+        inline static typename var::ptr_t parse(istream_t & s) { return details::parse<definition, istream_t>(s); }
+
+        inline static typename var::ptr_t parse(const char * begin, const char * end) { return details::parse<definition>(begin, end); }
+
+        inline static typename var::ptr_t parse(std::string_view s) { return parse(s.data(), s.data() + s.size()); }
+    }
+
+    // object keys shared through a key_table across any number of parses, keys compare by address
+    namespace interned {
+        using definition = details::definition<details::unique_ptr, details::hash_map, std::vector, double, std::string, std::ostream, details::interned_key>;
+
+        using var = typename definition::var_t;
+        using object = typename definition::object_t;
+        using array = typename definition::array_t;
+        using primitive = typename definition::primitive_t;
+        using number = typename definition::number_t;
+        using literal = typename definition::literal_t;
+        using key = typename definition::key_t;
+        using key_table = details::key_table;
+
+        using parser = details::parser<definition, details::interning_factory<definition>>;
+
+        // keys has to outlive the returned tree
+        inline static typename var::ptr_t parse(const char * begin, const char * end, key_table & keys) { return parser::parse(begin, end, details::interning_factory<definition>{ &keys }); }
+
+        inline static typename var::ptr_t parse(std::string_view s, key_table & keys) { return parse(s.data(), s.data() + s.size(), keys); }
+    }
+
+    namespace arena {
+        using definition = details::definition<details::arena_ptr, details::arena_map, details::arena_vector, double, details::arena_string, std::ostream>;
+
+        using var = typename definition::var_t;
+        using object = typename definition::object_t;
+        using array = typename definition::array_t;
+        using primitive = typename definition::primitive_t;
+        using number = typename definition::number_t;
+        using literal = typename definition::literal_t;
+    }
+
+    // parses into a single arena, see details::document
+    using document = details::document<arena::definition>;
+
+    // newline delimited or concatenated documents, see details::document_stream
+    using document_stream = details::document_stream<arena::definition>;
+
+    // as document_stream, constructed with parse_limits every document is held to on its own
+    using bounded_document_stream = details::document_stream<arena::definition, details::arena_checker>;
+
+    // newline delimited documents parsed on worker threads, see details::batch_parser
+    namespace parallel {
+        // f(const arena::var::ptr_t &) is called on the calling thread in document order, a root is valid during its call;
+        // returns the number of documents
+        template<typename f_t>
+        inline static std::size_t parse(const char * begin, const char * end, f_t && f, parallel_options o = {}) {
+            details::batch_parser<arena::definition> p(begin, end, o);
+            return p.run(f);
+        }
+
+        template<typename f_t>
+        inline static std::size_t parse(std::string_view s, f_t && f, parallel_options o = {}) { return parse(s.data(), s.data() + s.size(), f, o); }
+
+        // as parse(), every document held to limits on its own
+        template<typename f_t>
+        inline static std::size_t parse(const char * begin, const char * end, f_t && f, parallel_options o, const parse_limits & limits) {
+            details::batch_parser<arena::definition, details::arena_checker> p(begin, end, o, limits);
+            return p.run(f);
+        }
+
+        template<typename f_t>
+        inline static std::size_t parse(std::string_view s, f_t && f, parallel_options o, const parse_limits & limits) { return parse(s.data(), s.data() + s.size(), f, o, limits); }
+    }
+
+    // immutable flat document, see details::tape
+    using tape = details::tape;
+
+    namespace view {
+        using definition = details::definition<details::arena_ptr, details::arena_map, details::arena_vector, double, std::string_view, std::ostream>;
+
+        using var = typename definition::var_t;
+        using object = typename definition::object_t;
+        using array = typename definition::array_t;
+        using primitive = typename definition::primitive_t;
+        using number = typename definition::number_t;
+        using literal = typename definition::literal_t;
+    }
+
+    // an arena document with literals referring to the parsed text instead of owning copies
+    using view_document = details::document<view::definition>;
+
+    // a view document over a mapped file kept alive with it, see details::file_document
+    using file_document = details::file_document<view::definition>;
+
+    namespace compact {
+        using definition = details::compact_definition<std::map, std::vector, double, std::string, std::ostream>;
+
+        using value = typename definition::value_t;
+        using var = typename definition::var_t;
+        using object = typename definition::object_t;
+        using array = typename definition::array_t;
+        using number = typename definition::number_t;
+        using literal = typename definition::literal_t;
+
+        using parser = details::parser<definition, details::compact_factory<definition>>;
+
+        template<typename istream_t, typename = decltype(std::declval<istream_t &>().rdbuf())>
+        inline static value parse(istream_t & s) { return parser::parse(s); }
+
+        inline static value parse(const char * begin, const char * end, parse_options o = {}) {
+            details::compact_factory<definition> f;
+            f.exactIntegers = o.exactIntegers;
+            return parser::parse(begin, end, f);
+        }
+
+        inline static value parse(std::string_view s, parse_options o = {}) { return parse(s.data(), s.data() + s.size(), o); }
+    }
+
 }
 
 #endif
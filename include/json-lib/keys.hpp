@@ -0,0 +1,134 @@
+
+#ifndef HEADER_JSON_PARSER_KEYS
+#define HEADER_JSON_PARSER_KEYS 1
+
+#include <string>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <functional>
+#include <string_view>
+
+#include "definition.hpp"
+#include "arena.hpp"
+#include "containers.hpp"
+
+namespace json {
+    namespace details {
+
+        // immutable key storage shared through a key_table, the characters follow the header
+        struct key_entry {
+            std::size_t hash;
+            std::size_t size;
+
+            const char * data() const noexcept { return reinterpret_cast<const char *>(this + 1); }
+        };
+
+        // handle to a key of a key_table, keys of the same table are equal when their handles are;
+        // ordering compares the characters so sorted containers stay deterministic
+        struct interned_key {
+            interned_key() noexcept = default;
+            explicit interned_key(const key_entry * e) noexcept : e(e) {}
+
+            const char * data() const noexcept { return e != nullptr ? e->data() : ""; }
+            std::size_t size() const noexcept { return e != nullptr ? e->size : 0; }
+            std::size_t hash() const noexcept { return e != nullptr ? e->hash : 0; }
+            bool empty() const noexcept { return size() == 0; }
+
+            // false for a handle that refers to no key
+            explicit operator bool() const noexcept { return e != nullptr; }
+
+            operator std::string_view() const noexcept { return { data(), size() }; }
+
+            bool operator==(const interned_key & k) const noexcept { return e == k.e; }
+            bool operator!=(const interned_key & k) const noexcept { return e != k.e; }
+            bool operator<(const interned_key & k) const noexcept { return e != k.e && std::string_view(*this) < std::string_view(k); }
+
+        private:
+            const key_entry * e = nullptr;
+        };
+
+        template<>
+        struct key_hash<interned_key> {
+            std::size_t operator()(const interned_key & k) const noexcept { return k.hash(); }
+        };
+
+        // stores every distinct key once, handles stay valid for the lifetime of the table;
+        // one table can serve any number of parses, but is not synchronized
+        struct key_table {
+
+            key_table() = default;
+            key_table(const key_table &) = delete;
+            key_table & operator=(const key_table &) = delete;
+            key_table(key_table &&) = default;
+            key_table & operator=(key_table &&) = default;
+
+            // the handle of k, stored on first use
+            interned_key intern(std::string_view k) {
+                const auto h = std::hash<std::string_view>()(k);
+                const auto i = index.find(lookup_t{ k, h });
+                if (i != index.end()) { return interned_key(i->second); }
+                auto e = static_cast<key_entry *>(a.allocate(sizeof(key_entry) + k.size(), alignof(key_entry)));
+                e->hash = h;
+                e->size = k.size();
+                std::memcpy(const_cast<char *>(e->data()), k.data(), k.size());
+                index.emplace(lookup_t{ std::string_view(e->data(), k.size()), h }, e);
+                return interned_key(e);
+            }
+
+            // the handle of k, or an empty handle if k was never stored
+            interned_key find(std::string_view k) const {
+                const auto i = index.find(lookup_t{ k, std::hash<std::string_view>()(k) });
+                return i != index.end() ? interned_key(i->second) : interned_key();
+            }
+
+            std::size_t size() const noexcept { return index.size(); }
+
+            std::size_t bytesReserved() const noexcept { return a.bytesReserved(); }
+
+        private:
+
+            struct lookup_t {
+                std::string_view k;
+                std::size_t h;
+                bool operator==(const lookup_t & o) const noexcept { return k == o.k; }
+            };
+
+            struct lookup_hash {
+                std::size_t operator()(const lookup_t & l) const noexcept { return l.h; }
+            };
+
+            arena a;
+            hash_map<lookup_t, const key_entry *, lookup_hash> index;
+        };
+
+        // heap tree factory reading object keys through a key_table, a repeated key costs no allocation
+        template<typename definition_t>
+        struct interning_factory : tree_factory<definition_t, interning_factory<definition_t>> {
+            using key_t = typename definition_t::key_t;
+
+            explicit interning_factory(key_table * keys) noexcept : keys(keys) {}
+
+            key_table * keys;
+            std::string scratch;
+
+            template<typename x, typename ... args_t>
+            x * make(args_t && ... args) { return new x(std::forward<args_t>(args)...); }
+
+            typename definition_t::literal_t literal() { return {}; }
+
+            // only a key new to the table is copied
+            key_t readKey(const char *& p, const char * e, parse_stats * stats = nullptr) {
+                const auto n = keys->size();
+                auto k = keys->intern(readLiteralView(p, e, scratch, stats));
+                if (stats != nullptr && keys->size() != n) { ++stats->allocations; }
+                return k;
+            }
+
+            key_t copyKey(std::string_view v) { return keys->intern(v); }
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,294 @@
+
+#ifndef HEADER_JSON_PARSER_LAZY
+#define HEADER_JSON_PARSER_LAZY 1
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <typeinfo>
+#include <stdexcept>
+#include <string_view>
+
+#include "definition.hpp"
+
+namespace json {
+    namespace details {
+
+        // p is past the opening quote, returns the position past the closing quote
+        inline static const char * skipLiteral(const char * p, const char * e) {
+            auto escaped = false;
+            const auto q = literalEnd(p, e, escaped);
+            if (q == nullptr) { throw std::runtime_error("failed to read json"); }
+            return q;
+        }
+
+        // returns the position past the value starting at p, the content of a container is only checked for balanced
+        // brackets, see valueEnd
+        inline static const char * skipValue(const char * p, const char * e) {
+            switch (bufferPeek(p, e)) {
+                case '"':
+                case '{':
+                case '[':
+                {
+                    const auto q = valueEnd(p, e);
+                    if (q == nullptr) { throw std::runtime_error("failed to read json"); }
+                    return q;
+                }
+                case 'n': readWord(p, e, "null", 4); return p;
+                case 't': readWord(p, e, "true", 4); return p;
+                case 'f': readWord(p, e, "false", 5); return p;
+                default: readJsonNumber(p, e); return p;
+            }
+        }
+
+        // p is past the opening quote and is moved past the closing quote
+        inline static bool literalEquals(const char *& p, const char * e, std::string_view v) {
+            const auto q = scanLiteral(p, e);
+            if (q != e && *q == '"') {
+                const auto r = std::string_view(p, static_cast<std::size_t>(q - p)) == v;
+                p = q + 1;
+                return r;
+            }
+            std::string l(p, q);
+            p = q;
+            readLiteralTail(p, e, l);
+            return l == v;
+        }
+
+        // p is past a container element, returns the next element or nullptr past the closing bracket
+        inline static const char * nextElement(const char * p, const char * e, char close) {
+            skipWhitespaces(p, e);
+            const auto c = bufferGet(p, e);
+            if (c == close) { return nullptr; }
+            if (c != ',') { throw std::runtime_error("failed to parse json"); }
+            skipWhitespaces(p, e);
+            return p;
+        }
+
+        // p is at a member key, returns its value
+        inline static const char * memberValue(const char * p, const char * e) {
+            if (bufferGet(p, e) != '"') { throw std::runtime_error("failed to parse json"); }
+            p = skipLiteral(p, e);
+            skipWhitespaces(p, e);
+            if (bufferGet(p, e) != ':') { throw std::runtime_error("failed to parse json"); }
+            skipWhitespaces(p, e);
+            return p;
+        }
+
+        // a value inside a json buffer, nothing is read until asked for; lookups scan forward from the value and
+        // skip unread containers by bracket matching, so the buffer is only fully validated where it is accessed
+        struct cursor {
+
+            using type_t = value_type;
+
+            struct member_t;
+            struct element_iterator;
+            struct member_iterator;
+
+            template<typename iterator_t>
+            struct range_t {
+                iterator_t b;
+                iterator_t begin() const noexcept { return b; }
+                iterator_t end() const noexcept { return {}; }
+            };
+
+            cursor() noexcept = default;
+            cursor(const char * p, const char * e) noexcept : p(p), e(e) {}
+
+            // false for a lookup that found nothing
+            explicit operator bool() const noexcept { return p != nullptr; }
+
+            type_t type() const {
+                switch (bufferPeek(p, e)) {
+                    case '{': return type_t::object;
+                    case '[': return type_t::array;
+                    case '"': return type_t::literal;
+                    case 't':
+                    case 'f': return type_t::boolean;
+                    case 'n': return type_t::null;
+                    default:
+                        if (*p == '-' || isDigit(*p)) { return type_t::number; }
+                        throw std::runtime_error("failed to parse json");
+                }
+            }
+
+            bool isNull() const { return type() == type_t::null; }
+            bool isObject() const { return type() == type_t::object; }
+            bool isArray() const { return type() == type_t::array; }
+            bool isPrimitive() const { return !isObject() && !isArray(); }
+
+            // the member named k, or an empty cursor; of duplicate keys this is the first, the lookup stops there,
+            // where a parsed tree keeps the last one; members() visits every duplicate
+            cursor find(std::string_view k) const {
+                for (auto q = first('{', '}'); q != nullptr; q = nextElement(skipValue(q, e), e, '}')) {
+                    if (bufferGet(q, e) != '"') { throw std::runtime_error("failed to parse json"); }
+                    const auto match = literalEquals(q, e, k);
+                    skipWhitespaces(q, e);
+                    if (bufferGet(q, e) != ':') { throw std::runtime_error("failed to parse json"); }
+                    skipWhitespaces(q, e);
+                    if (match) { return { q, e }; }
+                }
+                return {};
+            }
+
+            // as find(), the first of duplicate keys
+            cursor operator[](std::string_view k) const {
+                const auto r = find(k);
+                if (!r) { throw std::out_of_range("json key not found"); }
+                return r;
+            }
+
+            cursor at(std::size_t i) const {
+                for (auto q = first('[', ']'); q != nullptr; q = nextElement(skipValue(q, e), e, ']')) {
+                    if (i-- == 0) { return { q, e }; }
+                }
+                throw std::out_of_range("json index out of range");
+            }
+
+            cursor operator[](std::size_t i) const { return at(i); }
+
+            // number of elements or members
+            std::size_t size() const {
+                std::size_t n = 0;
+                if (isObject()) {
+                    for (auto q = first('{', '}'); q != nullptr; q = nextElement(skipValue(memberValue(q, e), e), e, '}')) { ++n; }
+                } else {
+                    for (auto q = first('[', ']'); q != nullptr; q = nextElement(skipValue(q, e), e, ']')) { ++n; }
+                }
+                return n;
+            }
+
+            range_t<element_iterator> elements() const;
+
+            range_t<member_iterator> members() const;
+
+            number_token token() const {
+                if (type() != type_t::number) { throw std::bad_cast(); }
+                auto q = p;
+                return readJsonNumber(q, e);
+            }
+
+            double number() const { return token().floating(); }
+
+            std::int64_t integer() const { return token().as<std::int64_t>(); }
+
+            std::uint64_t uinteger() const { return token().as<std::uint64_t>(); }
+
+            bool boolean() const {
+                if (type() != type_t::boolean) { throw std::bad_cast(); }
+                auto q = p;
+                readWord(q, e, *p == 't' ? "true" : "false", *p == 't' ? 4 : 5);
+                return *p == 't';
+            }
+
+            std::string literal() const {
+                if (type() != type_t::literal) { throw std::bad_cast(); }
+                std::string r;
+                auto q = p;
+                readLiteral(q, e, r);
+                return r;
+            }
+
+            // a view into the buffer when the literal has no escapes, otherwise decoded into scratch
+            std::string_view literal(std::string & scratch) const {
+                if (type() != type_t::literal) { throw std::bad_cast(); }
+                auto q = p;
+                return readLiteralView(q, e, scratch);
+            }
+
+            // compares a literal without decoding it unless it has escapes
+            bool operator==(std::string_view v) const {
+                if (type() != type_t::literal) { return false; }
+                auto q = p + 1;
+                return literalEquals(q, e, v);
+            }
+
+            bool operator!=(std::string_view v) const { return !operator==(v); }
+
+            // the json text of the value
+            std::string_view raw() const { return { p, static_cast<std::size_t>(skipValue(p, e) - p) }; }
+
+        private:
+
+            const char * p = nullptr;
+            const char * e = nullptr;
+
+            // the first element or member of the container, nullptr if it is empty
+            const char * first(char open, char close) const {
+                if (bufferPeek(p, e) != open) { throw std::bad_cast(); }
+                auto q = p + 1;
+                skipWhitespaces(q, e);
+                if (bufferPeek(q, e) == close) { return nullptr; }
+                return q;
+            }
+
+        };
+
+        struct cursor::member_t {
+            cursor key;
+            cursor value;
+        };
+
+        struct cursor::element_iterator {
+            element_iterator() noexcept = default;
+            element_iterator(const char * p, const char * e) noexcept : p(p), e(e) {}
+
+            cursor operator*() const noexcept { return { p, e }; }
+
+            element_iterator & operator++() {
+                p = nextElement(skipValue(p, e), e, ']');
+                return *this;
+            }
+
+            bool operator==(const element_iterator & o) const noexcept { return p == o.p; }
+            bool operator!=(const element_iterator & o) const noexcept { return p != o.p; }
+
+        private:
+            const char * p = nullptr;
+            const char * e = nullptr;
+        };
+
+        struct cursor::member_iterator {
+            member_iterator() noexcept = default;
+            member_iterator(const char * p, const char * e) : p(p), e(e), v(p != nullptr ? memberValue(p, e) : nullptr) {}
+
+            member_t operator*() const noexcept { return { { p, e }, { v, e } }; }
+
+            member_iterator & operator++() {
+                p = nextElement(skipValue(v, e), e, '}');
+                v = p != nullptr ? memberValue(p, e) : nullptr;
+                return *this;
+            }
+
+            bool operator==(const member_iterator & o) const noexcept { return p == o.p; }
+            bool operator!=(const member_iterator & o) const noexcept { return p != o.p; }
+
+        private:
+            const char * p = nullptr;
+            const char * e = nullptr;
+            const char * v = nullptr;
+        };
+
+        inline cursor::range_t<cursor::element_iterator> cursor::elements() const { return { element_iterator(first('[', ']'), e) }; }
+
+        inline cursor::range_t<cursor::member_iterator> cursor::members() const { return { member_iterator(first('{', '}'), e) }; }
+
+    }
+
+    namespace lazy {
+
+        using value = details::cursor;
+
+        // nothing is read past the root's first character, the buffer has to outlive every value reached from it
+        inline static value parse(const char * begin, const char * end) {
+            details::skipWhitespaces(begin, end);
+            details::bufferPeek(begin, end);
+            return { begin, end };
+        }
+
+        inline static value parse(std::string_view s) { return parse(s.data(), s.data() + s.size()); }
+
+    }
+}
+
+#endif
@@ -0,0 +1,173 @@
+
+#ifndef HEADER_JSON_PARSER_LIMITS
+#define HEADER_JSON_PARSER_LIMITS 1
+
+#include <limits>
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include "scan.hpp"
+#include "stats.hpp"
+
+namespace json {
+
+    // bounds a parse of untrusted text is held to, everything is unbounded by default
+    struct parse_limits {
+        std::size_t maxDepth = std::numeric_limits<std::size_t>::max();
+        // length of the text
+        std::size_t maxBytes = std::numeric_limits<std::size_t>::max();
+        // length of a literal or key as written, escapes included
+        std::size_t maxStringLength = std::numeric_limits<std::size_t>::max();
+        // values of every kind, containers included
+        std::size_t maxNodes = std::numeric_limits<std::size_t>::max();
+        // arena bytes for documents, an estimate from nodes and literals otherwise
+        std::size_t maxMemory = std::numeric_limits<std::size_t>::max();
+    };
+
+    enum struct limit : unsigned char { depth, bytes, string, nodes, memory };
+
+    // thrown when a parse exceeds one of its parse_limits, offset is where the offending value starts
+    struct limit_error : std::runtime_error {
+        limit_error(json::limit which, std::size_t offset) : std::runtime_error(message(which, offset)), which(which), offset(offset) {}
+
+        json::limit which;
+        std::size_t offset;
+
+    private:
+
+        static std::string message(json::limit which, std::size_t offset) {
+            static const char * const names[] = { "depth", "bytes", "string length", "nodes", "memory" };
+            return std::string("failed to parse json: ") + names[static_cast<int>(which)] + " limit exceeded at offset " + std::to_string(offset);
+        }
+    };
+
+    namespace details {
+
+        // parser policy enforcing parse_limits with a few counters per value, see no_stats for the hooks; each document
+        // is held to the limits on its own, workers of one document together; memory is read from the arena_t documents
+        // allocate from, estimated as nodeBytes per value plus literal bytes without one
+        template<typename arena_t = void>
+        struct limits_checker {
+            parse_limits l;
+            std::size_t nodeBytes = 0;
+            const arena_t * a = nullptr;
+            const char * b = nullptr;
+            // text of the document before b, when it arrives in chunks
+            std::size_t base = 0;
+            // of a worker's values in the document
+            std::size_t depth = 0;
+            std::size_t nodes = 0;
+            std::size_t estimate = 0;
+
+            limits_checker(const parse_limits & l = {}, std::size_t nodeBytes = 0, const arena_t * a = nullptr) noexcept : l(l), nodeBytes(nodeBytes), a(a) {}
+
+            // the whole text is refused before anything is read or copied
+            static void check(const parse_limits & l, const char * begin, const char * end) {
+                if (static_cast<std::size_t>(end - begin) > l.maxBytes) { throw limit_error(limit::bytes, l.maxBytes); }
+            }
+
+            void start(const char * p) noexcept {
+                b = p;
+                base = nodes = estimate = 0;
+            }
+
+            // the counts of a finished document are not joined
+            void finish(const char * p) {
+                if (offset(p) > l.maxBytes) { throw limit_error(limit::bytes, l.maxBytes); }
+                memory(p);
+                nodes = estimate = 0;
+            }
+
+            void move(const char * from, const char * to) {
+                base = offset(from);
+                b = to;
+                if (base > l.maxBytes) { throw limit_error(limit::bytes, l.maxBytes); }
+            }
+
+            limits_checker fork(std::size_t d) const noexcept {
+                limits_checker w{ l, nodeBytes, a };
+                w.b = b;
+                w.base = base;
+                w.depth = d;
+                return w;
+            }
+
+            // p is where the worker's part of the document starts
+            void join(const limits_checker & w, const char * p) {
+                nodes += w.nodes;
+                estimate += w.estimate;
+                if (nodes > l.maxNodes) { fail(limit::nodes, p); }
+                memory(p);
+            }
+
+            void value(const char * p) {
+                if (++nodes > l.maxNodes) { fail(limit::nodes, p); }
+                estimate += nodeBytes;
+                memory(p);
+            }
+
+            void container(const char * p, bool, std::size_t d) const {
+                if (depth + d > l.maxDepth) { fail(limit::depth, p); }
+            }
+
+            void key(const char * p, const char * e) { text(p, e); }
+            void literal(const char * p, const char * e) { text(p, e); }
+
+            void number() const noexcept {}
+            void boolean() const noexcept {}
+            void null() const noexcept {}
+            parse_stats * counters() const noexcept { return nullptr; }
+
+        private:
+
+            std::size_t offset(const char * p) const noexcept { return base + static_cast<std::size_t>(p - b); }
+
+            [[noreturn]] void fail(limit which, const char * p) const { throw limit_error(which, offset(p)); }
+
+            void memory(const char * p) const {
+                if constexpr (std::is_void<arena_t>::value) {
+                    if (estimate > l.maxMemory) { fail(limit::memory, p); }
+                } else {
+                    if (a != nullptr && a->bytesAllocated() > l.maxMemory) { fail(limit::memory, p); }
+                }
+            }
+
+            // [p, e) is a literal or key as read by the parser, quotes included, so its length costs no scan of its own
+            void text(const char * p, const char * e) {
+                const auto n = static_cast<std::size_t>(e - p) - 2;
+                if (n > l.maxStringLength) { fail(limit::string, p); }
+                estimate += n;
+            }
+        };
+
+        // points a checker of arena bytes at the arena a document is read into, other policies have no use for it
+        template<typename stats_t, typename arena_t>
+        inline static void watchArena(stats_t & s, const arena_t & a) noexcept {
+            if constexpr (std::is_same<stats_t, limits_checker<arena_t>>::value) {
+                s.a = &a;
+            } else {
+                static_cast<void>(s);
+                static_cast<void>(a);
+            }
+        }
+
+        template<typename option_t>
+        struct document_reader;
+
+        // document::parse(begin, end, limits), memory is held to the arena bytes of the document
+        template<>
+        struct document_reader<parse_limits> {
+            template<typename document_t>
+            static document_t & read(document_t & d, const char * begin, const char * end, const parse_limits & limits) {
+                using checker_t = limits_checker<std::remove_reference_t<decltype(*d.a)>>;
+                checker_t::check(limits, begin, end);
+                return d.read(begin, end, checker_t{ limits, 0, d.a.get() });
+            }
+        };
+
+    }
+}
+
+#endif
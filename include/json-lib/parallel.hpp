@@ -0,0 +1,388 @@
+
+#ifndef HEADER_JSON_PARSER_PARALLEL
+#define HEADER_JSON_PARSER_PARALLEL 1
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <condition_variable>
+
+#include "definition.hpp"
+#include "arena.hpp"
+#include "keys.hpp"
+#include "stream.hpp"
+#include "limits.hpp"
+
+namespace json {
+
+    struct parallel_options {
+        // worker threads, 0 for one per hardware thread
+        std::size_t threads = 0;
+        // largest batch handed to a worker, smaller batches are used until every worker has several
+        std::size_t chunkSize = 1 << 20;
+    };
+
+    namespace details {
+
+        // runs task(i) for every i of [0, n) on worker threads; each worker takes indices from the front of its own
+        // contiguous range and steals from the back of the others, so uneven tasks still keep every worker busy
+        struct task_pool {
+
+            template<typename task_t>
+            task_pool(std::size_t threads, std::size_t n, task_t task) : task(std::move(task)), ready(new bool[n]()), errors(n) {
+                if (threads > n) { threads = n; }
+                if (threads == 0) { threads = 1; }
+                queues.reset(new queue_t[threads]);
+                this->threads = threads;
+                for (std::size_t w = 0; w < threads; ++w) {
+                    queues[w].begin = n * w / threads;
+                    queues[w].end = n * (w + 1) / threads;
+                }
+                // the destructor does not run for a constructor that throws, workers already started are joined here
+                try {
+                    workers.reserve(threads);
+                    for (std::size_t w = 0; w < threads; ++w) { workers.emplace_back([this, w] { work(w); }); }
+                } catch (...) {
+                    stop();
+                    throw;
+                }
+            }
+
+            task_pool(const task_pool &) = delete;
+            task_pool & operator=(const task_pool &) = delete;
+
+            ~task_pool() { stop(); }
+
+            // blocks until task i is finished and rethrows what it threw, stopping the pool first
+            void wait(std::size_t i) {
+                {
+                    std::unique_lock<std::mutex> l(m);
+                    done.wait(l, [&] { return ready[i]; });
+                }
+                if (errors[i]) {
+                    stop();
+                    std::rethrow_exception(errors[i]);
+                }
+            }
+
+            // lets the running tasks finish and joins the workers, remaining tasks are dropped
+            void stop() noexcept {
+                stopped = true;
+                for (auto & t : workers) { t.join(); }
+                workers.clear();
+            }
+
+        private:
+
+            struct queue_t {
+                std::mutex m;
+                std::size_t begin = 0;
+                std::size_t end = 0;
+            };
+
+            std::function<void(std::size_t)> task;
+            std::unique_ptr<bool[]> ready;
+            std::vector<std::exception_ptr> errors;
+            std::unique_ptr<queue_t[]> queues;
+            std::vector<std::thread> workers;
+            std::size_t threads = 1;
+            std::atomic<bool> stopped{ false };
+            std::mutex m;
+            std::condition_variable done;
+
+            bool take(std::size_t w, std::size_t & i) {
+                {
+                    auto & q = queues[w];
+                    std::lock_guard<std::mutex> l(q.m);
+                    if (q.begin != q.end) {
+                        i = q.begin++;
+                        return true;
+                    }
+                }
+                for (std::size_t k = 1; k < threads; ++k) {
+                    auto & q = queues[(w + k) % threads];
+                    std::lock_guard<std::mutex> l(q.m);
+                    if (q.begin != q.end) {
+                        i = --q.end;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void work(std::size_t w) {
+                std::size_t i;
+                while (!stopped.load(std::memory_order_relaxed) && take(w, i)) {
+                    try {
+                        task(i);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                    {
+                        std::lock_guard<std::mutex> l(m);
+                        ready[i] = true;
+                    }
+                    done.notify_all();
+                }
+            }
+        };
+
+        inline static std::size_t workerCount(std::size_t threads) noexcept {
+            if (threads == 0) { threads = std::thread::hardware_concurrency(); }
+            return threads != 0 ? threads : 1;
+        }
+
+        // parses newline delimited documents of [begin, end) on a task_pool and hands every root to f on the calling
+        // thread in document order; the buffer is split at newlines into chunks, each parsed into its own arena,
+        // a chunk is released once delivered, the first error in document order is rethrown after the workers stop;
+        // every chunk is read with a fork of stats, joined back once the chunk is delivered
+        template<typename definition_t, typename stats_t = no_stats>
+        struct batch_parser {
+
+            using var_t = typename definition_t::var_t;
+            using ptr_t = typename var_t::ptr_t;
+            using factory_t = arena_factory<definition_t>;
+
+            static constexpr std::size_t minChunkSize = 1 << 12;
+
+            batch_parser(const char * begin, const char * end, parallel_options o, stats_t stats = {}) : threads(workerCount(o.threads)), stats(std::move(stats)) { split(begin, end, o.chunkSize); }
+
+            template<typename f_t>
+            std::size_t run(f_t & f) {
+                if (chunks.empty()) { return 0; }
+                task_pool pool(threads, chunks.size(), [this](std::size_t i) { parse(chunks[i]); });
+                std::size_t n = 0;
+                for (std::size_t i = 0; i < chunks.size(); ++i) {
+                    pool.wait(i);
+                    auto & c = chunks[i];
+                    stats.join(c.stats, c.begin);
+                    for (const auto & r : c.roots) { f(r); }
+                    n += c.roots.size();
+                    c.roots = std::vector<ptr_t>();
+                    c.a = arena();
+                }
+                return n;
+            }
+
+        private:
+
+            struct chunk_t {
+                const char * begin;
+                const char * end;
+                arena a;
+                std::vector<ptr_t> roots;
+                stats_t stats;
+            };
+
+            std::vector<chunk_t> chunks;
+            std::size_t threads;
+            stats_t stats;
+
+            // chunks end after a newline, so no document is cut as long as each one sits on its own line
+            void split(const char * begin, const char * end, std::size_t chunkSize) {
+                const auto size = static_cast<std::size_t>(end - begin);
+                auto target = size / (threads * 8);
+                if (target > chunkSize) { target = chunkSize; }
+                if (target < minChunkSize) { target = minChunkSize; }
+                for (auto s = begin; s != end;) {
+                    auto l = static_cast<std::size_t>(end - s) > target ? s + target : end;
+                    if (l != end) {
+                        const auto nl = static_cast<const char *>(std::memchr(l, '\n', static_cast<std::size_t>(end - l)));
+                        l = nl != nullptr ? nl + 1 : end;
+                    }
+                    chunks.push_back(chunk_t{ s, l, arena(), {}, stats.fork(0) });
+                    s = l;
+                }
+            }
+
+            void parse(chunk_t & c) {
+                parser<definition_t, factory_t, stats_t> p(c.begin, c.end, factory_t{ &c.a }, std::move(c.stats));
+                watchArena(p.stats, c.a);
+                for (auto s = c.begin;;) {
+                    skipWhitespaces(s, c.end);
+                    if (s == c.end) {
+                        c.stats = std::move(p.stats);
+                        return;
+                    }
+                    auto l = valueEnd(s, c.end);
+                    if (l == nullptr) { l = c.end; }
+                    p.reset(s, l);
+                    c.roots.push_back(p.read());
+                    if (p.s != l) { throw std::runtime_error("failed to parse json"); }
+                    s = l;
+                }
+            }
+        };
+
+        // whether copies of a factory can make values on several threads at once, copies of an arena_factory share one
+        // arena and copies of an interning_factory one key_table, neither of them locked
+        template<typename factory_t>
+        struct independent_copies : std::true_type {};
+
+        template<typename definition_t>
+        struct independent_copies<arena_factory<definition_t>> : std::false_type {};
+
+        template<typename definition_t>
+        struct independent_copies<interning_factory<definition_t>> : std::false_type {};
+
+        // parses one document whose root array or object is large: a serial pass over the top level finds element
+        // boundaries by bracket matching only, then ranges of elements are parsed concurrently and attached to the
+        // root in document order, so the tree is the one a serial parse builds; the factory is copied per range,
+        // stats is forked per range and the forks joined in document order
+        template<typename definition_t, typename factory_t = heap_factory<definition_t>, typename stats_t = no_stats>
+        struct split_parser {
+
+            static_assert(independent_copies<factory_t>::value, "split_parser needs a factory whose copies share no state");
+
+            using value_t = typename factory_t::value_t;
+            using key_t = typename factory_t::key_t;
+
+            static constexpr std::size_t minRangeSize = 1 << 14;
+
+            static value_t parse(const char * begin, const char * end, parallel_options o, factory_t factory = {}, stats_t stats = {}) {
+                const auto threads = workerCount(o.threads);
+                auto s = begin;
+                skipWhitespaces(s, end);
+                const auto size = static_cast<std::size_t>(end - s);
+                if (threads < 2 || size < minRangeSize * 2 || (*s != '[' && *s != '{')) { return parser<definition_t, factory_t, stats_t>::parse(begin, end, std::move(factory), std::move(stats)); }
+
+                split_parser p{ *s == '{', std::move(factory), std::move(stats) };
+                p.stats.start(begin);
+                p.stats.value(s);
+                p.stats.container(s, p.object, 1);
+                auto target = size / (threads * 8);
+                if (target > o.chunkSize) { target = o.chunkSize; }
+                if (target < minRangeSize) { target = minRangeSize; }
+                p.split(s + 1, end, target);
+                auto r = p.run(threads);
+                p.stats.finish(p.close);
+                auto l = p.close;
+                skipWhitespaces(l, end);
+                if (l != end) { throw std::runtime_error("failed to parse json"); }
+                return r;
+            }
+
+        private:
+
+            struct range_t {
+                const char * begin;
+                const char * end;
+                std::vector<key_t> keys;
+                std::vector<value_t> values;
+                stats_t stats;
+            };
+
+            bool object;
+            factory_t factory;
+            stats_t stats;
+            std::vector<range_t> ranges;
+            std::size_t count = 0;
+            // past the closing bracket of the root
+            const char * close = nullptr;
+
+            split_parser(bool object, factory_t factory, stats_t stats) : object(object), factory(std::move(factory)), stats(std::move(stats)) {}
+
+            // ranges of whole members, each ends before the separator that follows its last member
+            void split(const char * s, const char * end, std::size_t target) {
+                skipWhitespaces(s, end);
+                if (bufferPeek(s, end) == (object ? '}' : ']')) {
+                    close = s + 1;
+                    return;
+                }
+                for (auto r = s;;) {
+                    if (object) {
+                        if (bufferPeek(s, end) != '"') { throw std::runtime_error("failed to parse json"); }
+                        s = next(s, end);
+                        skipWhitespaces(s, end);
+                        if (bufferGet(s, end) != ':') { throw std::runtime_error("failed to parse json"); }
+                        skipWhitespaces(s, end);
+                    }
+                    s = next(s, end);
+                    ++count;
+                    const auto l = s;
+                    skipWhitespaces(s, end);
+                    const auto c = bufferGet(s, end);
+                    const auto last = c == (object ? '}' : ']');
+                    if (!last && c != ',') { throw std::runtime_error("failed to parse json"); }
+                    if (last || static_cast<std::size_t>(l - r) >= target) {
+                        ranges.push_back(range_t{ r, l, {}, {}, stats.fork(1) });
+                        r = s;
+                    }
+                    if (last) {
+                        close = s;
+                        return;
+                    }
+                    skipWhitespaces(s, end);
+                }
+            }
+
+            static const char * next(const char * s, const char * end) {
+                const auto l = valueEnd(s, end);
+                // a separator or closing bracket where an element belongs, as in "[1,]"
+                if (l == s) { throw std::runtime_error("failed to parse json"); }
+                if (l != nullptr) { return l; }
+                // a scalar may end the buffer, the parser reports anything else
+                bufferPeek(s, end);
+                if (*s == '"' || *s == '{' || *s == '[') { throw std::runtime_error("failed to parse json"); }
+                return end;
+            }
+
+            void parse(range_t & r) const {
+                parser<definition_t, factory_t, stats_t> p(r.begin, r.end, factory, std::move(r.stats));
+                for (auto s = r.begin; s != r.end;) {
+                    skipWhitespaces(s, r.end);
+                    if (object) {
+                        const auto k = s;
+                        r.keys.push_back(p.factory.readKey(s, r.end, p.stats.counters()));
+                        p.stats.key(k, s);
+                        skipWhitespaces(s, r.end);
+                        ++s;
+                    }
+                    p.reset(s, r.end);
+                    r.values.push_back(p.readElement());
+                    s = p.s;
+                    skipWhitespaces(s, r.end);
+                    if (s != r.end) { ++s; }
+                }
+                r.stats = std::move(p.stats);
+            }
+
+            value_t run(std::size_t threads) {
+                auto root = object ? factory.makeObject(stats.counters()) : factory.makeArray(stats.counters());
+                task_pool pool(threads, ranges.size(), [this](std::size_t i) { parse(ranges[i]); });
+                if (object) {
+                    auto & o = *factory.tryAsObject(root);
+                    for (std::size_t i = 0; i < ranges.size(); ++i) {
+                        pool.wait(i);
+                        auto & r = ranges[i];
+                        stats.join(r.stats, r.begin);
+                        for (std::size_t k = 0; k < r.values.size(); ++k) { factory.set(o, std::move(r.keys[k]), std::move(r.values[k])); }
+                        r = range_t{};
+                    }
+                    factory.close(o);
+                } else {
+                    auto & a = *factory.tryAsArray(root);
+                    factory.reserve(a, count);
+                    for (std::size_t i = 0; i < ranges.size(); ++i) {
+                        pool.wait(i);
+                        stats.join(ranges[i].stats, ranges[i].begin);
+                        for (auto & v : ranges[i].values) { factory.add(a, std::move(v)); }
+                        ranges[i] = range_t{};
+                    }
+                }
+                return root;
+            }
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,125 @@
+
+#ifndef HEADER_JSON_PARSER_PUSH
+#define HEADER_JSON_PARSER_PUSH 1
+
+#include <string>
+#include <cstddef>
+#include <utility>
+#include <stdexcept>
+#include <string_view>
+
+#include "definition.hpp"
+
+namespace json {
+
+    enum struct push_status : unsigned char { more, done };
+
+    namespace details {
+
+        // incremental parser fed with chunks of any size as they arrive, the reader resumes at the token a chunk
+        // ended on; only a token cut by the end of a chunk is copied; the factory has to own its literals,
+        // stats_t is told about each document as one text, see no_stats::move
+        template<typename definition_t_, typename factory_t_ = heap_factory<definition_t_>, typename stats_t_ = no_stats>
+        struct push_parser {
+
+            using definition_t = definition_t_;
+            using factory_t = factory_t_;
+            using stats_t = stats_t_;
+            using value_t = typename factory_t::value_t;
+
+            explicit push_parser(factory_t factory = {}, stats_t stats = {}) : p(nullptr, nullptr, std::move(factory), std::move(stats)) {}
+
+            // parses [data, data + n) up to the end of the current document; done leaves the bytes after it unread,
+            // see consumed(), more means the document continues in the next chunk
+            push_status feed(const char * data, std::size_t n) {
+                if (p.done()) { throw std::logic_error("json document already complete"); }
+                auto s = data;
+                const auto e = data + n;
+                if (!pending.empty()) {
+                    const auto l = pending[0] == '"' ? literalEnd(s, e, escaped) : scalarEnd(s, e);
+                    if (l == nullptr) {
+                        pending.append(s, e);
+                        used = n;
+                        return push_status::more;
+                    }
+                    pending.append(s, l);
+                    s = l;
+                    resume(pending.data(), pending.data() + pending.size(), true);
+                    pending.clear();
+                }
+                if (!p.done()) {
+                    resume(s, e, false);
+                    s = p.done() ? p.s : e;
+                }
+                used = static_cast<std::size_t>(s - data);
+                return p.done() ? push_status::done : push_status::more;
+            }
+
+            push_status feed(std::string_view s) { return feed(s.data(), s.size()); }
+
+            // no more input, a number or word at the end completes the document, anything else missing throws
+            push_status finish() {
+                if (!p.done() && !pending.empty()) {
+                    resume(pending.data(), pending.data() + pending.size(), true);
+                    pending.clear();
+                }
+                if (!p.done()) { throw std::runtime_error("failed to read json"); }
+                return push_status::done;
+            }
+
+            // bytes of the last chunk belonging to the documents so far
+            std::size_t consumed() const noexcept { return used; }
+
+            // the completed document, the parser starts over for the next one
+            value_t take() {
+                if (!p.done()) { throw std::logic_error("json document not complete"); }
+                p.reset(nullptr, nullptr);
+                started = false;
+                return std::move(p.root);
+            }
+
+            // drops a partial document
+            void reset() noexcept {
+                p.reset(nullptr, nullptr);
+                p.root = value_t();
+                p.key = typename parser<definition_t, factory_t, stats_t>::key_t();
+                pending.clear();
+                escaped = false;
+                started = false;
+                used = 0;
+            }
+
+        private:
+
+            parser<definition_t, factory_t, stats_t> p;
+            std::string pending;
+            bool escaped = false;
+            bool started = false;
+            std::size_t used = 0;
+
+            // continues the document with [s, e), a token cut by e is kept in pending unless last
+            void resume(const char * s, const char * e, bool last) {
+                if (started) {
+                    p.stats.move(p.s, s);
+                } else {
+                    p.stats.start(s);
+                    started = true;
+                }
+                p.s = s;
+                p.end = e;
+                p.resume(p, last);
+                if (p.done()) {
+                    p.stats.finish(p.s);
+                    return;
+                }
+                if (p.s == e) { return; }
+                pending.assign(p.s, e);
+                escaped = false;
+                if (pending[0] == '"') { literalEnd(pending.data() + 1, pending.data() + pending.size(), escaped); }
+            }
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,103 @@
+
+#ifndef HEADER_JSON_PARSER_SAX
+#define HEADER_JSON_PARSER_SAX 1
+
+#include <string>
+#include <utility>
+#include <string_view>
+
+#include "definition.hpp"
+#include "limits.hpp"
+
+namespace json {
+    namespace details {
+
+        // passes the reader's events on to a sax handler, strings are decoded into scratch when they have escapes
+        template<typename handler_t>
+        struct sax_events {
+            handler_t & h;
+            std::string & scratch;
+            parse_stats * stats;
+
+            bool onNull() { return h.onNull(); }
+            bool onBoolean(bool b) { return h.onBoolean(b); }
+            bool onNumber(const number_token & n) { return h.onNumber(n); }
+            bool onString(const char *& p, const char * e) { return h.onString(readLiteralView(p, e, scratch, stats)); }
+            bool onKey(const char *& p, const char * e) { return h.onKey(readLiteralView(p, e, scratch, stats)); }
+            bool onObjectStart() { return h.onObjectStart(); }
+            bool onObjectEnd() { return h.onObjectEnd(); }
+            bool onArrayStart() { return h.onArrayStart(); }
+            bool onArrayEnd() { return h.onArrayEnd(); }
+        };
+
+        // drives a handler over [begin, end) without building values, every handler event returns false to stop the parse
+        template<typename stats_t = no_stats>
+        struct sax_reader : reader<stats_t> {
+
+            std::string scratch;
+
+            explicit sax_reader(stats_t stats = {}) : reader<stats_t>(nullptr, nullptr, std::move(stats)) {}
+
+            // returns false if the handler stopped the parse, the reader is left past the last consumed character
+            template<typename handler_t>
+            bool parse(const char * b, const char * e, handler_t & h) {
+                this->reset(b, e);
+                sax_events<handler_t> events{ h, scratch, this->stats.counters() };
+                return this->readDocument(events);
+            }
+
+            // as parse(), a parse the handler did not stop throws on anything but whitespace after the value
+            template<typename handler_t>
+            bool parseAll(const char * b, const char * e, handler_t & h) {
+                if (!parse(b, e, h)) { return false; }
+                this->expectEnd();
+                return true;
+            }
+
+        };
+
+    }
+
+    namespace sax {
+
+        using number_token = details::number_token;
+
+        // accepts every event, derive and hide the events of interest,
+        // string views passed to onKey/onString are only valid during the call
+        struct handler {
+            bool onNull() { return true; }
+            bool onBoolean(bool) { return true; }
+            bool onNumber(const number_token &) { return true; }
+            bool onString(std::string_view) { return true; }
+            bool onKey(std::string_view) { return true; }
+            bool onObjectStart() { return true; }
+            bool onObjectEnd() { return true; }
+            bool onArrayStart() { return true; }
+            bool onArrayEnd() { return true; }
+        };
+
+        // returns false if the handler stopped the parse early
+        template<typename handler_t>
+        inline static bool parse(const char * begin, const char * end, handler_t & h) {
+            details::sax_reader<> r;
+            return r.parseAll(begin, end, h);
+        }
+
+        template<typename handler_t>
+        inline static bool parse(std::string_view s, handler_t & h) { return parse(s.data(), s.data() + s.size(), h); }
+
+        // as parse(), throwing limit_error once the text exceeds limits; no values are kept, memory is taken as the literal bytes
+        template<typename handler_t>
+        inline static bool parse(const char * begin, const char * end, handler_t & h, const parse_limits & limits) {
+            details::limits_checker<>::check(limits, begin, end);
+            details::sax_reader<details::limits_checker<>> r{ limits };
+            return r.parseAll(begin, end, h);
+        }
+
+        template<typename handler_t>
+        inline static bool parse(std::string_view s, handler_t & h, const parse_limits & limits) { return parse(s.data(), s.data() + s.size(), h, limits); }
+
+    }
+}
+
+#endif
@@ -0,0 +1,251 @@
+
+#ifndef HEADER_JSON_PARSER_SCAN
+#define HEADER_JSON_PARSER_SCAN 1
+
+#include <cstddef>
+#include <cstdint>
+
+// block scanning is selected at compile time from the target instruction set,
+// define JSON_LIB_NO_SIMD to force the scalar fallback
+#if !defined(JSON_LIB_NO_SIMD)
+#   if defined(__AVX2__)
+#       define JSON_LIB_AVX2 1
+#   endif
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define JSON_LIB_SSE2 1
+#   endif
+#endif
+
+#if defined(JSON_LIB_SSE2) || defined(JSON_LIB_AVX2)
+#   include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace json {
+    namespace details {
+
+        inline static unsigned countTrailingZeros(std::uint32_t m) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long r;
+            _BitScanForward(&r, m);
+            return static_cast<unsigned>(r);
+#else
+            return static_cast<unsigned>(__builtin_ctz(m));
+#endif
+        }
+
+        // ' ', '\t', '\n', '\v', '\f', '\r'
+        inline static bool isWhitespaceByte(unsigned char c) noexcept { return c == ' ' || static_cast<unsigned char>(c - '\t') <= ('\r' - '\t'); }
+
+        // '"', '\\' or a control character
+        inline static bool isLiteralSpecialByte(unsigned char c) noexcept { return c == '"' || c == '\\' || c < 0x20; }
+
+        // characters written escaped, literal specials and '/'
+        inline static bool isEscapedByte(unsigned char c) noexcept { return isLiteralSpecialByte(c) || c == '/'; }
+
+        // '"' and brackets, '[' and ']' differ from '{' and '}' only in bit 0x20
+        inline static bool isStructuralByte(unsigned char c) noexcept { return c == '"' || (c | 0x20) == '{' || (c | 0x20) == '}'; }
+
+#if defined(JSON_LIB_AVX2)
+        inline static std::uint32_t whitespaceMask32(const char * p) noexcept {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            const auto t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+            const auto ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8('\r' - '\t')), t);
+            const auto sp = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+            return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(ctl, sp)));
+        }
+
+        inline static std::uint32_t literalSpecialMask32(const char * p) noexcept {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            const auto q = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+            const auto b = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+            const auto c = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1f)), v);
+            return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(q, b), c)));
+        }
+
+        inline static std::uint32_t escapedMask32(const char * p) noexcept {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            const auto s = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'));
+            return literalSpecialMask32(p) | static_cast<std::uint32_t>(_mm256_movemask_epi8(s));
+        }
+
+        inline static std::uint32_t structuralMask32(const char * p) noexcept {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            const auto f = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+            const auto q = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+            const auto o = _mm256_cmpeq_epi8(f, _mm256_set1_epi8('{'));
+            const auto c = _mm256_cmpeq_epi8(f, _mm256_set1_epi8('}'));
+            return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(q, o), c)));
+        }
+
+        inline static std::uint32_t nonAsciiMask32(const char * p) noexcept { return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)))); }
+#endif
+
+#if defined(JSON_LIB_SSE2)
+        inline static std::uint32_t whitespaceMask16(const char * p) noexcept {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            const auto t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+            const auto ctl = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8('\r' - '\t')), t);
+            const auto sp = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(ctl, sp)));
+        }
+
+        inline static std::uint32_t literalSpecialMask16(const char * p) noexcept {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            const auto q = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+            const auto b = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+            const auto c = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v);
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(q, b), c)));
+        }
+
+        inline static std::uint32_t escapedMask16(const char * p) noexcept {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            const auto s = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+            return literalSpecialMask16(p) | static_cast<std::uint32_t>(_mm_movemask_epi8(s));
+        }
+
+        inline static std::uint32_t structuralMask16(const char * p) noexcept {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            const auto f = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            const auto q = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+            const auto o = _mm_cmpeq_epi8(f, _mm_set1_epi8('{'));
+            const auto c = _mm_cmpeq_epi8(f, _mm_set1_epi8('}'));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(q, o), c)));
+        }
+
+        inline static std::uint32_t nonAsciiMask16(const char * p) noexcept { return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)))); }
+#endif
+
+        // returns the first non-whitespace position in [p, e), or e
+        inline static const char * scanWhitespaces(const char * p, const char * e) noexcept {
+            // most runs are empty or a single separator, don't pay for a block load
+            if (p == e || !isWhitespaceByte(static_cast<unsigned char>(*p))) { return p; }
+            ++p;
+#if defined(JSON_LIB_AVX2)
+            for (; e - p >= 32; p += 32) {
+                const auto m = ~whitespaceMask32(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+#if defined(JSON_LIB_SSE2)
+            for (; e - p >= 16; p += 16) {
+                const auto m = ~whitespaceMask16(p) & 0xffffu;
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+            while (p != e && isWhitespaceByte(static_cast<unsigned char>(*p))) { ++p; }
+            return p;
+        }
+
+        // returns the first '"', '\\' or control character position in [p, e), or e
+        inline static const char * scanLiteral(const char * p, const char * e) noexcept {
+#if defined(JSON_LIB_AVX2)
+            for (; e - p >= 32; p += 32) {
+                const auto m = literalSpecialMask32(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+#if defined(JSON_LIB_SSE2)
+            for (; e - p >= 16; p += 16) {
+                const auto m = literalSpecialMask16(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+            while (p != e && !isLiteralSpecialByte(static_cast<unsigned char>(*p))) { ++p; }
+            return p;
+        }
+
+        // returns the first character position in [p, e) that has to be written escaped, or e
+        inline static const char * scanEscapes(const char * p, const char * e) noexcept {
+#if defined(JSON_LIB_AVX2)
+            for (; e - p >= 32; p += 32) {
+                const auto m = escapedMask32(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+#if defined(JSON_LIB_SSE2)
+            for (; e - p >= 16; p += 16) {
+                const auto m = escapedMask16(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+            while (p != e && !isEscapedByte(static_cast<unsigned char>(*p))) { ++p; }
+            return p;
+        }
+
+        // returns the first '"', '{', '}', '[' or ']' position in [p, e), or e
+        inline static const char * scanStructural(const char * p, const char * e) noexcept {
+#if defined(JSON_LIB_AVX2)
+            for (; e - p >= 32; p += 32) {
+                const auto m = structuralMask32(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+#if defined(JSON_LIB_SSE2)
+            for (; e - p >= 16; p += 16) {
+                const auto m = structuralMask16(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+            while (p != e && !isStructuralByte(static_cast<unsigned char>(*p))) { ++p; }
+            return p;
+        }
+
+        // returns the first byte position in [p, e) that is not ASCII, or e
+        inline static const char * scanAscii(const char * p, const char * e) noexcept {
+#if defined(JSON_LIB_AVX2)
+            for (; e - p >= 32; p += 32) {
+                const auto m = nonAsciiMask32(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+#if defined(JSON_LIB_SSE2)
+            for (; e - p >= 16; p += 16) {
+                const auto m = nonAsciiMask16(p);
+                if (m != 0) { return p + countTrailingZeros(m); }
+            }
+#endif
+            while (p != e && static_cast<unsigned char>(*p) < 0x80) { ++p; }
+            return p;
+        }
+
+        // whether [p, e) is well-formed UTF-8: shortest forms only, no surrogates, nothing past U+10FFFF;
+        // ASCII runs are skipped a block at a time and only multi-byte sequences are decoded
+        inline static bool isValidUtf8(const char * p, const char * e) noexcept {
+            for (;;) {
+                p = scanAscii(p, e);
+                if (p == e) { return true; }
+                const auto c = static_cast<unsigned char>(*p);
+                // bounds of the second byte, the others are plain continuation bytes
+                unsigned char lo = 0x80, hi = 0xbf;
+                std::ptrdiff_t n;
+                if (c >= 0xc2 && c <= 0xdf) {
+                    n = 2;
+                } else if (c >= 0xe0 && c <= 0xef) {
+                    n = 3;
+                    if (c == 0xe0) { lo = 0xa0; }
+                    if (c == 0xed) { hi = 0x9f; }
+                } else if (c >= 0xf0 && c <= 0xf4) {
+                    n = 4;
+                    if (c == 0xf0) { lo = 0x90; }
+                    if (c == 0xf4) { hi = 0x8f; }
+                } else {
+                    return false;
+                }
+                if (e - p < n) { return false; }
+                const auto c1 = static_cast<unsigned char>(p[1]);
+                if (c1 < lo || c1 > hi) { return false; }
+                for (std::ptrdiff_t i = 2; i < n; ++i) {
+                    if ((static_cast<unsigned char>(p[i]) & 0xc0) != 0x80) { return false; }
+                }
+                p += n;
+            }
+        }
+
+    }
+}
+
+#endif
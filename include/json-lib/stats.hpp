@@ -0,0 +1,142 @@
+
+#ifndef HEADER_JSON_PARSER_STATS
+#define HEADER_JSON_PARSER_STATS 1
+
+#include <chrono>
+#include <cstddef>
+
+namespace json {
+
+    // counters of parses, each parse adds to them and maxDepth keeps the largest
+    struct parse_stats {
+        std::size_t documents = 0;
+        // input consumed, whitespace after a document excluded
+        std::size_t bytes = 0;
+        std::size_t objects = 0;
+        std::size_t arrays = 0;
+        std::size_t keys = 0;
+        std::size_t literals = 0;
+        std::size_t numbers = 0;
+        std::size_t booleans = 0;
+        std::size_t nulls = 0;
+        std::size_t maxDepth = 0;
+        // decoded bytes of literals and keys, what a copying definition stores
+        std::size_t literalBytes = 0;
+        std::size_t escapes = 0;
+        // nodes made and literals or keys copied, by the heap or the arena; values a compact value holds inline take none
+        std::size_t allocations = 0;
+        // bytes taken from the arena, arena documents only
+        std::size_t arenaBytes = 0;
+        std::chrono::nanoseconds time{ 0 };
+
+        std::size_t values() const noexcept { return objects + arrays + literals + numbers + booleans + nulls; }
+
+        parse_stats & operator+=(const parse_stats & o) noexcept {
+            documents += o.documents;
+            bytes += o.bytes;
+            objects += o.objects;
+            arrays += o.arrays;
+            keys += o.keys;
+            literals += o.literals;
+            numbers += o.numbers;
+            booleans += o.booleans;
+            nulls += o.nulls;
+            if (o.maxDepth > maxDepth) { maxDepth = o.maxDepth; }
+            literalBytes += o.literalBytes;
+            escapes += o.escapes;
+            allocations += o.allocations;
+            arenaBytes += o.arenaBytes;
+            time += o.time;
+            return *this;
+        }
+    };
+
+    // counters of serializations, each one adds to them and maxDepth keeps the largest
+    struct print_stats {
+        std::size_t documents = 0;
+        // output produced
+        std::size_t bytes = 0;
+        std::size_t values = 0;
+        std::size_t maxDepth = 0;
+        std::size_t escapes = 0;
+        // buffers handed to a sink
+        std::size_t chunks = 0;
+        std::chrono::nanoseconds time{ 0 };
+    };
+
+    namespace details {
+
+        // parser statistics policy that records nothing and compiles away; start and finish bound a document,
+        // move tells that its text continues at another address, fork and join give a worker reading part of it
+        // at some depth a policy of its own and fold that back once the worker is done; counters() is where
+        // decoding literals and making values add literal bytes, escapes and allocations, nullptr for none; key and
+        // literal get a string as written, quotes included, after it was read
+        struct no_stats {
+            void start(const char *) noexcept {}
+            void finish(const char *) noexcept {}
+            void move(const char *, const char *) noexcept {}
+            no_stats fork(std::size_t) const noexcept { return {}; }
+            void join(const no_stats &, const char *) noexcept {}
+            void value(const char *) noexcept {}
+            void container(const char *, bool, std::size_t) noexcept {}
+            void key(const char *, const char *) noexcept {}
+            void literal(const char *, const char *) noexcept {}
+            void number() noexcept {}
+            void boolean() noexcept {}
+            void null() noexcept {}
+            parse_stats * counters() noexcept { return nullptr; }
+        };
+
+        // parser statistics policy adding to a parse_stats; a document is counted on its own and added to s when it is finished, a worker's counts when it is joined
+        struct stats_recorder {
+            parse_stats * s = nullptr;
+            const char * b = nullptr;
+            std::chrono::steady_clock::time_point t0{};
+            parse_stats c{};
+            std::size_t depth = 0;
+
+            void start(const char * p) noexcept {
+                b = p;
+                t0 = std::chrono::steady_clock::now();
+            }
+
+            void finish(const char * p) noexcept {
+                c.time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0);
+                c.bytes += static_cast<std::size_t>(p - b);
+                ++c.documents;
+                if (s != nullptr) {
+                    *s += c;
+                    c = parse_stats{};
+                }
+            }
+
+            void move(const char * from, const char * to) noexcept {
+                c.bytes += static_cast<std::size_t>(from - b);
+                b = to;
+            }
+
+            stats_recorder fork(std::size_t d) const noexcept { return { nullptr, b, t0, {}, d }; }
+
+            void join(const stats_recorder & w, const char *) noexcept { (s != nullptr ? *s : c) += w.c; }
+
+            void value(const char *) noexcept {}
+
+            void container(const char *, bool object, std::size_t d) noexcept {
+                ++(object ? c.objects : c.arrays);
+                if (depth + d > c.maxDepth) { c.maxDepth = depth + d; }
+            }
+
+            void key(const char *, const char *) noexcept { ++c.keys; }
+            void literal(const char *, const char *) noexcept { ++c.literals; }
+
+            void number() noexcept { ++c.numbers; }
+            void boolean() noexcept { ++c.booleans; }
+            void null() noexcept { ++c.nulls; }
+
+            parse_stats * counters() noexcept { return &c; }
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,146 @@
+
+#ifndef HEADER_JSON_PARSER_STREAM
+#define HEADER_JSON_PARSER_STREAM 1
+
+#include <ios>
+#include <string>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <stdexcept>
+#include <string_view>
+
+#include "definition.hpp"
+#include "arena.hpp"
+#include "limits.hpp"
+
+namespace json {
+    namespace details {
+
+        template<typename istream_t>
+        inline static std::size_t readFromStream(void * s, char * d, std::size_t n) {
+            auto & i = *static_cast<istream_t *>(s);
+            i.read(d, static_cast<std::streamsize>(n));
+            return static_cast<std::size_t>(i.gcount());
+        }
+
+        // successive documents of a buffer or stream, newline delimited or simply concatenated;
+        // one parser, arena and input window serve every document, so memory is bounded by the largest document;
+        // stats_t is told about every document, limits_checker<arena> reads the arena bytes of each
+        template<typename definition_t_, typename stats_t_ = no_stats>
+        struct document_stream {
+
+            using definition_t = definition_t_;
+            using stats_t = stats_t_;
+            using var_t = typename definition_t::var_t;
+            using ptr_t = typename var_t::ptr_t;
+            using factory_t = arena_factory<definition_t>;
+            using source_t = std::size_t (*)(void * context, char * data, std::size_t size);
+
+            static constexpr std::size_t defaultChunkSize = 1 << 20;
+
+            struct iterator {
+                document_stream * d = nullptr;
+
+                const ptr_t & operator*() const noexcept { return d->root(); }
+                const ptr_t * operator->() const noexcept { return &d->root(); }
+
+                iterator & operator++() {
+                    if (!d->next()) { d = nullptr; }
+                    return *this;
+                }
+
+                bool operator==(const iterator & o) const noexcept { return d == o.d; }
+                bool operator!=(const iterator & o) const noexcept { return d != o.d; }
+            };
+
+            // documents of [begin, end), the buffer has to outlive the stream
+            document_stream(const char * begin, const char * end, stats_t stats = {}) : p(begin, end, factory_t{ &a }, std::move(stats)), s(begin), e(end) { watchArena(p.stats, a); }
+
+            explicit document_stream(std::string_view v, stats_t stats = {}) : document_stream(v.data(), v.data() + v.size(), std::move(stats)) {}
+
+            // documents read from s in chunks of chunkSize, the window only grows for a document larger than it
+            template<typename istream_t, typename = decltype(std::declval<istream_t &>().rdbuf())>
+            explicit document_stream(istream_t & is, std::size_t chunkSize = defaultChunkSize, stats_t stats = {})
+                : p(nullptr, nullptr, factory_t{ &a }, std::move(stats)), source(&readFromStream<istream_t>), context(&is), chunkSize(chunkSize > 0 ? chunkSize : 1) {
+                watchArena(p.stats, a);
+            }
+
+            document_stream(const document_stream &) = delete;
+            document_stream & operator=(const document_stream &) = delete;
+
+            // parses the next document, false once the input is exhausted; the previous root is released
+            bool next() {
+                r = nullptr;
+                a.reset();
+                for (;;) {
+                    skipWhitespaces(s, e);
+                    const auto q = valueEnd(s, e);
+                    if (q != nullptr || (s != e && exhausted())) {
+                        const auto l = q != nullptr ? q : e;
+                        p.reset(s, l);
+                        r = p.read();
+                        if (p.s != l) { throw std::runtime_error("failed to parse json"); }
+                        s = l;
+                        ++n;
+                        return true;
+                    }
+                    if (exhausted()) { return false; }
+                    refill();
+                }
+            }
+
+            // the current document, valid until the next call to next()
+            const ptr_t & root() const noexcept { return r; }
+
+            // number of documents read so far
+            std::size_t count() const noexcept { return n; }
+
+            std::size_t bytesReserved() const noexcept { return a.bytesReserved() + window.capacity(); }
+
+            iterator begin() { return next() ? iterator{ this } : iterator{}; }
+            iterator end() noexcept { return {}; }
+
+        private:
+
+            arena a;
+            parser<definition_t, factory_t, stats_t> p;
+            ptr_t r;
+            const char * s = nullptr;
+            const char * e = nullptr;
+            std::size_t n = 0;
+
+            source_t source = nullptr;
+            void * context = nullptr;
+            std::size_t chunkSize = defaultChunkSize;
+            std::string window;
+            bool eof = false;
+
+            bool exhausted() const noexcept { return source == nullptr || eof; }
+
+            // keeps the unread tail and appends at least one chunk after it
+            void refill() {
+                const auto keep = static_cast<std::size_t>(e - s);
+                if (keep != 0 && s != window.data()) { std::memmove(&window[0], s, keep); }
+                auto size = keep + chunkSize > window.size() ? keep + chunkSize : window.size();
+                if (keep > size / 2) { size = keep * 2; }
+                window.resize(size);
+                std::size_t filled = keep;
+                while (filled < size) {
+                    const auto got = source(context, &window[filled], size - filled);
+                    if (got == 0) {
+                        eof = true;
+                        break;
+                    }
+                    filled += got;
+                }
+                s = window.data();
+                e = window.data() + filled;
+            }
+
+        };
+
+    }
+}
+
+#endif
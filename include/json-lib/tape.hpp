@@ -0,0 +1,413 @@
+
+#ifndef HEADER_JSON_PARSER_TAPE
+#define HEADER_JSON_PARSER_TAPE 1
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <typeinfo>
+#include <stdexcept>
+#include <string_view>
+
+#include "definition.hpp"
+#include "sax.hpp"
+#include "limits.hpp"
+
+namespace json {
+    namespace details {
+
+        // an immutable document as one array of 64 bit entries and one literal buffer, both can be copied as bytes;
+        // an entry is a tag in the high byte and a 56 bit payload:
+        //  '{' '[' index past the matching close in the low 32 bits, element count (saturated) in the next 24
+        //  '}' ']' index of the matching open
+        //  '"' offset of a 32 bit length followed by the literal bytes in the literal buffer
+        //  'd' 'l' 'u' double, int64_t or uint64_t in the next entry
+        //  'n' 't' 'f' no payload
+        struct tape {
+
+            using entry_t = std::uint64_t;
+
+            struct value_t;
+            struct object_t;
+            struct array_t;
+
+            tape() = default;
+            tape(std::vector<entry_t> entries, std::string literals) : e(std::move(entries)), l(std::move(literals)) {}
+
+            tape & parse(const char * begin, const char * end) { return parse(begin, end, no_stats{}); }
+
+            tape & parse(std::string_view s) { return parse(s.data(), s.data() + s.size()); }
+
+            // as parse(), throwing limit_error once the text or the tape exceeds limits, memory is estimated as one entry
+            // per value and the literal bytes
+            tape & parse(const char * begin, const char * end, const parse_limits & limits) {
+                limits_checker<>::check(limits, begin, end);
+                return parse(begin, end, limits_checker<>{ limits, sizeof(entry_t) });
+            }
+
+            tape & parse(std::string_view s, const parse_limits & limits) { return parse(s.data(), s.data() + s.size(), limits); }
+
+            // a parse that throws leaves the tape empty, never with the entries read up to the error
+            template<typename stats_t>
+            tape & parse(const char * begin, const char * end, stats_t stats) {
+                clear();
+                builder b{ *this };
+                sax_reader<stats_t> r{ std::move(stats) };
+                try {
+                    r.parseAll(begin, end, b);
+                } catch (...) {
+                    clear();
+                    throw;
+                }
+                return *this;
+            }
+
+            value_t root() const;
+
+            void clear() noexcept {
+                e.clear();
+                l.clear();
+            }
+
+            const std::vector<entry_t> & entries() const noexcept { return e; }
+
+            const std::string & literals() const noexcept { return l; }
+
+        private:
+
+            static constexpr entry_t payloadMask = (entry_t(1) << 56) - 1;
+            static constexpr entry_t indexMask = (entry_t(1) << 32) - 1;
+            static constexpr entry_t countMax = (entry_t(1) << 24) - 1;
+
+            std::vector<entry_t> e;
+            std::string l;
+
+            static constexpr entry_t make(char tag, entry_t payload = 0) noexcept { return (entry_t(static_cast<unsigned char>(tag)) << 56) | payload; }
+
+            char tag(std::size_t i) const noexcept { return static_cast<char>(e[i] >> 56); }
+
+            entry_t payload(std::size_t i) const noexcept { return e[i] & payloadMask; }
+
+            // index past the value at i
+            std::size_t next(std::size_t i) const noexcept {
+                switch (tag(i)) {
+                    case '{':
+                    case '[': return static_cast<std::size_t>(payload(i) & indexMask);
+                    case 'd':
+                    case 'l':
+                    case 'u': return i + 2;
+                    default: return i + 1;
+                }
+            }
+
+            std::string_view literal(std::size_t i) const noexcept {
+                const auto o = static_cast<std::size_t>(payload(i));
+                std::uint32_t n;
+                std::memcpy(&n, l.data() + o, sizeof(n));
+                return { l.data() + o + sizeof(n), n };
+            }
+
+            struct builder : sax::handler {
+                tape & t;
+                std::vector<std::size_t> open;
+                std::vector<entry_t> counts;
+
+                explicit builder(tape & t) noexcept : t(t) {}
+
+                void element() {
+                    if (!open.empty() && t.tag(open.back()) == '[') { ++counts.back(); }
+                }
+
+                template<typename x>
+                void number(char tag, x v) {
+                    element();
+                    entry_t b;
+                    std::memcpy(&b, &v, sizeof(b));
+                    t.e.push_back(make(tag));
+                    t.e.push_back(b);
+                }
+
+                void literal(char tag, std::string_view v) {
+                    if (v.size() > 0xffffffffu) { throw std::runtime_error("failed to parse json: literal too long"); }
+                    const auto n = static_cast<std::uint32_t>(v.size());
+                    t.e.push_back(make(tag, t.l.size()));
+                    t.l.append(reinterpret_cast<const char *>(&n), sizeof(n));
+                    t.l.append(v.data(), v.size());
+                }
+
+                bool start(char tag) {
+                    element();
+                    open.push_back(t.e.size());
+                    counts.push_back(0);
+                    t.e.push_back(make(tag));
+                    return true;
+                }
+
+                bool finish(char tag) {
+                    const auto i = open.back();
+                    const auto n = counts.back() < countMax ? counts.back() : countMax;
+                    if (t.e.size() + 1 > indexMask) { throw std::runtime_error("failed to parse json: document too large"); }
+                    t.e[i] |= (n << 32) | (t.e.size() + 1);
+                    t.e.push_back(make(tag, i));
+                    open.pop_back();
+                    counts.pop_back();
+                    return true;
+                }
+
+                bool onNull() { element(); t.e.push_back(make('n')); return true; }
+                bool onBoolean(bool b) { element(); t.e.push_back(make(b ? 't' : 'f')); return true; }
+                bool onNumber(const number_token & n) {
+                    switch (n.kind) {
+                        case number_token::kind_t::integer: number('l', n.i); break;
+                        case number_token::kind_t::uinteger: number('u', n.u); break;
+                        default: number('d', n.d); break;
+                    }
+                    return true;
+                }
+                bool onString(std::string_view v) { element(); literal('"', v); return true; }
+                bool onKey(std::string_view k) { ++counts.back(); literal('"', k); return true; }
+                bool onObjectStart() { return start('{'); }
+                bool onObjectEnd() { return finish('}'); }
+                bool onArrayStart() { return start('['); }
+                bool onArrayEnd() { return finish(']'); }
+            };
+
+        };
+
+        // a read-only view of a value on a tape, valid while the tape is unchanged
+        struct tape::value_t {
+            using type_t = value_type;
+
+            value_t(const tape * t, std::size_t i) noexcept : t(t), i(i) {}
+
+            type_t type() const noexcept {
+                switch (t->tag(i)) {
+                    case '{': return type_t::object;
+                    case '[': return type_t::array;
+                    case '"': return type_t::literal;
+                    case 't':
+                    case 'f': return type_t::boolean;
+                    case 'n': return type_t::null;
+                    default: return type_t::number;
+                }
+            }
+
+            bool isNull() const noexcept { return t->tag(i) == 'n'; }
+            bool isObject() const noexcept { return t->tag(i) == '{'; }
+            bool isArray() const noexcept { return t->tag(i) == '['; }
+            bool isPrimitive() const noexcept { return !isObject() && !isArray(); }
+
+            object_t asObject() const;
+            array_t asArray() const;
+
+            const value_t & asPrimitive() const {
+                if (!isPrimitive()) { throw std::bad_cast(); }
+                return *this;
+            }
+
+            double number() const {
+                switch (t->tag(i)) {
+                    case 'd': return load<double>();
+                    case 'l': return static_cast<double>(load<std::int64_t>());
+                    case 'u': return static_cast<double>(load<std::uint64_t>());
+                    default: throw std::bad_cast();
+                }
+            }
+
+            bool isInteger() const noexcept { return t->tag(i) == 'l' || t->tag(i) == 'u'; }
+
+            std::int64_t integer() const {
+                if (t->tag(i) == 'u') { throw std::range_error("json number out of range"); }
+                if (t->tag(i) != 'l') { throw std::bad_cast(); }
+                return load<std::int64_t>();
+            }
+
+            std::uint64_t uinteger() const {
+                if (t->tag(i) == 'u') { return load<std::uint64_t>(); }
+                if (t->tag(i) != 'l') { throw std::bad_cast(); }
+                const auto v = load<std::int64_t>();
+                if (v < 0) { throw std::range_error("json number out of range"); }
+                return static_cast<std::uint64_t>(v);
+            }
+
+            bool boolean() const {
+                if (type() != type_t::boolean) { throw std::bad_cast(); }
+                return t->tag(i) == 't';
+            }
+
+            std::string_view literal() const {
+                if (t->tag(i) != '"') { throw std::bad_cast(); }
+                return t->literal(i);
+            }
+
+            void write(writer & w, int indent = -1, int layer = 0) const;
+
+            bool operator==(const value_t & v) const noexcept { return t == v.t && i == v.i; }
+            bool operator!=(const value_t & v) const noexcept { return !operator==(v); }
+
+        private:
+            friend struct tape;
+
+            const tape * t;
+            std::size_t i;
+
+            template<typename x>
+            x load() const noexcept {
+                x v;
+                std::memcpy(&v, &t->e[i + 1], sizeof(v));
+                return v;
+            }
+        };
+
+        struct tape::array_t {
+            struct iterator {
+                const tape * t;
+                std::size_t i;
+
+                value_t operator*() const noexcept { return { t, i }; }
+                iterator & operator++() noexcept {
+                    i = t->next(i);
+                    return *this;
+                }
+                bool operator==(const iterator & o) const noexcept { return i == o.i; }
+                bool operator!=(const iterator & o) const noexcept { return i != o.i; }
+            };
+
+            array_t(const tape * t, std::size_t i) noexcept : t(t), i(i) {}
+
+            iterator begin() const noexcept { return { t, i + 1 }; }
+            iterator end() const noexcept { return { t, t->next(i) - 1 }; }
+
+            bool empty() const noexcept { return t->next(i) == i + 2; }
+
+            std::size_t size() const noexcept {
+                const auto n = t->payload(i) >> 32;
+                if (n < countMax) { return static_cast<std::size_t>(n); }
+                std::size_t r = 0;
+                for (auto k = begin(); k != end(); ++k) { ++r; }
+                return r;
+            }
+
+            value_t at(std::size_t n) const {
+                for (auto k = begin(); k != end(); ++k) {
+                    if (n-- == 0) { return *k; }
+                }
+                throw std::out_of_range("json index out of range");
+            }
+
+            value_t operator[](std::size_t n) const { return at(n); }
+
+        private:
+            const tape * t;
+            std::size_t i;
+        };
+
+        struct tape::object_t {
+            struct member_t {
+                std::string_view first;
+                value_t second;
+            };
+
+            struct iterator {
+                const tape * t;
+                std::size_t i;
+
+                member_t operator*() const noexcept { return { t->literal(i), { t, i + 1 } }; }
+                iterator & operator++() noexcept {
+                    i = t->next(i + 1);
+                    return *this;
+                }
+                bool operator==(const iterator & o) const noexcept { return i == o.i; }
+                bool operator!=(const iterator & o) const noexcept { return i != o.i; }
+            };
+
+            object_t(const tape * t, std::size_t i) noexcept : t(t), i(i) {}
+
+            // members as written, duplicate keys included
+            iterator begin() const noexcept { return { t, i + 1 }; }
+            iterator end() const noexcept { return { t, t->next(i) - 1 }; }
+
+            bool empty() const noexcept { return t->next(i) == i + 2; }
+
+            // members as written, so duplicate keys count each time where a parsed object_t holds one of them
+            std::size_t size() const noexcept {
+                const auto n = t->payload(i) >> 32;
+                if (n < countMax) { return static_cast<std::size_t>(n); }
+                std::size_t r = 0;
+                for (auto k = begin(); k != end(); ++k) { ++r; }
+                return r;
+            }
+
+            // the last member with key k, like a parsed object_t
+            iterator find(std::string_view k) const noexcept {
+                auto r = end();
+                for (auto m = begin(); m != end(); ++m) {
+                    if (t->literal(m.i) == k) { r = m; }
+                }
+                return r;
+            }
+
+            std::size_t count(std::string_view k) const noexcept { return find(k) != end() ? 1 : 0; }
+
+            value_t at(std::string_view k) const {
+                const auto m = find(k);
+                if (m == end()) { throw std::out_of_range("json key not found"); }
+                return (*m).second;
+            }
+
+            value_t operator[](std::string_view k) const { return at(k); }
+
+        private:
+            const tape * t;
+            std::size_t i;
+        };
+
+        inline tape::value_t tape::root() const {
+            if (e.empty()) { throw std::runtime_error("empty json tape"); }
+            return { this, 0 };
+        }
+
+        inline tape::object_t tape::value_t::asObject() const {
+            if (!isObject()) { throw std::bad_cast(); }
+            return { t, i };
+        }
+
+        inline tape::array_t tape::value_t::asArray() const {
+            if (!isArray()) { throw std::bad_cast(); }
+            return { t, i };
+        }
+
+        inline void tape::value_t::write(writer & w, int indent, int layer) const {
+            switch (t->tag(i)) {
+                case '{':
+                {
+                    const auto o = asObject();
+                    w.container('{', '}', o.begin(), o.end(), indent, layer, [&](const object_t::member_t & m) {
+                        w.key(m.first, indent);
+                        m.second.write(w, indent, layer + 1);
+                    });
+                    break;
+                }
+                case '[':
+                {
+                    const auto a = asArray();
+                    w.container('[', ']', a.begin(), a.end(), indent, layer, [&](const value_t & v) { v.write(w, indent, layer + 1); });
+                    break;
+                }
+                case '"': w.literal(t->literal(i)); break;
+                case 't': w.boolean(true); break;
+                case 'f': w.boolean(false); break;
+                case 'd': w.number(load<double>()); break;
+                case 'l': w.number(load<std::int64_t>()); break;
+                case 'u': w.number(load<std::uint64_t>()); break;
+                default: w.null(); break;
+            }
+        }
+
+    }
+}
+
+#endif
@@ -0,0 +1,181 @@
+
+#ifndef HEADER_JSON_PARSER_WRITER
+#define HEADER_JSON_PARSER_WRITER 1
+
+#include <ios>
+#include <string>
+#include <sstream>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include <string_view>
+
+#include "scan.hpp"
+#include "number.hpp"
+#include "stats.hpp"
+
+namespace json {
+    namespace details {
+
+        // serializes into a contiguous buffer, with a sink the buffer is handed over in chunks of at least chunkSize
+        struct writer {
+            using sink_t = void (*)(void * context, const char * data, std::size_t size);
+
+            static constexpr std::size_t defaultChunkSize = 1 << 16;
+
+            writer() = default;
+            writer(sink_t sink, void * context, std::size_t chunkSize = defaultChunkSize) noexcept : sink(sink), context(context), chunkSize(chunkSize) {}
+
+            writer(const writer &) = delete;
+            writer & operator=(const writer &) = delete;
+
+            void put(char c) { out.push_back(c); }
+            void put(const char * d, std::size_t n) { out.append(d, n); }
+            void put(std::string_view v) { out.append(v.data(), v.size()); }
+
+            void newline(int indent) {
+                static constexpr char spaces[] = "\n                                                                ";
+                constexpr int width = static_cast<int>(sizeof(spaces)) - 2;
+                put(spaces, static_cast<std::size_t>((indent < width ? indent : width) + 1));
+                for (indent -= width; indent > 0; indent -= width) { put(spaces + 1, static_cast<std::size_t>(indent < width ? indent : width)); }
+            }
+
+            // counts into s from now on, one pointer test per value when unset
+            void instrument(print_stats * s) noexcept { stats = s; }
+
+            void null() {
+                value(0);
+                put("null", 4);
+            }
+
+            void boolean(bool b) {
+                value(0);
+                if (b) {
+                    put("true", 4);
+                } else {
+                    put("false", 5);
+                }
+            }
+
+            template<typename number_t>
+            void number(const number_t & n) {
+                value(0);
+                if constexpr (std::is_arithmetic<number_t>::value) {
+                    char b[maxNumberChars];
+                    put(b, static_cast<std::size_t>(formatNumber(b, n) - b));
+                } else {
+                    std::ostringstream s;
+                    s << n;
+                    put(s.str());
+                }
+            }
+
+            void literal(std::string_view v) {
+                value(0);
+                quoted(v);
+            }
+
+            template<typename literal_t>
+            void literal(const literal_t & l) { literal(std::string_view(l.data(), l.size())); }
+
+            void quoted(std::string_view v) {
+                static constexpr char hex[] = "0123456789abcdef";
+                put('"');
+                for (auto p = v.data(), e = p + v.size();;) {
+                    const auto q = scanEscapes(p, e);
+                    put(p, static_cast<std::size_t>(q - p));
+                    if (q == e) { break; }
+                    if (stats != nullptr) { ++stats->escapes; }
+                    switch (*q) {
+                        case '"': put("\\\"", 2); break;
+                        case '\\': put("\\\\", 2); break;
+                        case '/': put("\\/", 2); break;
+                        case '\b': put("\\b", 2); break;
+                        case '\f': put("\\f", 2); break;
+                        case '\n': put("\\n", 2); break;
+                        case '\r': put("\\r", 2); break;
+                        case '\t': put("\\t", 2); break;
+                        default:
+                        {
+                            const char u[] = { '\\', 'u', '0', '0', hex[(*q >> 4) & 0xf], hex[*q & 0xf] };
+                            put(u, sizeof(u));
+                        }
+                    }
+                    p = q + 1;
+                }
+                put('"');
+            }
+
+            // writes [i, l) between open and close, element_f writes a single element
+            template<typename iterator_t, typename element_f>
+            void container(char open, char close, iterator_t i, iterator_t l, int indent, int layer, element_f && f) {
+                value(static_cast<std::size_t>(layer) + 1);
+                put(open);
+                if (i != l) {
+                    if (indent >= 0) { newline(indent * (layer + 1)); }
+                    for (;;) {
+                        f(*i);
+                        ++i;
+                        if (i != l) { put(','); } else { break; }
+                        if (indent >= 0) { newline(indent * (layer + 1)); }
+                        chunk();
+                    }
+                    if (indent >= 0) { newline(indent * layer); }
+                }
+                put(close);
+            }
+
+            void key(std::string_view k, int indent) {
+                quoted(k);
+                if (indent >= 0) {
+                    put(": ", 2);
+                } else {
+                    put(':');
+                }
+            }
+
+            template<typename literal_t>
+            void key(const literal_t & k, int indent) { key(std::string_view(k.data(), k.size()), indent); }
+
+            // hands the buffer to the sink once a chunk is full
+            void chunk() {
+                if (sink != nullptr && out.size() >= chunkSize) { flush(); }
+            }
+
+            void flush() {
+                if (sink != nullptr && !out.empty()) {
+                    if (stats != nullptr) {
+                        stats->bytes += out.size();
+                        ++stats->chunks;
+                    }
+                    sink(context, out.data(), out.size());
+                    out.clear();
+                }
+            }
+
+            const std::string & str() const noexcept { return out; }
+
+            std::string release() noexcept { return std::move(out); }
+
+        private:
+            std::string out;
+            sink_t sink = nullptr;
+            void * context = nullptr;
+            std::size_t chunkSize = defaultChunkSize;
+            print_stats * stats = nullptr;
+
+            void value(std::size_t depth) noexcept {
+                if (stats != nullptr) {
+                    ++stats->values;
+                    if (depth > stats->maxDepth) { stats->maxDepth = depth; }
+                }
+            }
+        };
+
+        template<typename ostream_t>
+        inline static void writeToStream(void * s, const char * d, std::size_t n) { static_cast<ostream_t *>(s)->write(d, static_cast<std::streamsize>(n)); }
+
+    }
+}
+
+#endif
@@ -1,9 +1,30 @@
 
 #include <cassert>
+#include <string>
+#include <istream>
+#include <algorithm>
+#include <streambuf>
 #include <sstream>
+#include <stdexcept>
 
 #include "json-lib/json.hpp"
 
+// hands out its text a few bytes per underflow and cannot seek, as a pipe does
+struct pipe_buffer : std::streambuf {
+    std::string text;
+    std::size_t n = 0;
+
+    explicit pipe_buffer(std::string text) : text(std::move(text)) {}
+
+    int_type underflow() override {
+        if (n == text.size()) { return traits_type::eof(); }
+        const auto c = std::min<std::size_t>(3, text.size() - n);
+        setg(&text[n], &text[n], &text[n] + c);
+        n += c;
+        return traits_type::to_int_type(text[n - c]);
+    }
+};
+
 int main(int, char **) {
 
     std::stringstream ss{ R"(
@@ -67,4 +88,67 @@ int main(int, char **) {
 
     assert(*j == k);
 
+    { // a stream parse reads one value and leaves the stream past it
+        std::stringstream two{ "{\"a\":1} [2]\n3" };
+        assert(*json::parse(two) == json::O().set("a", new json::P(1)));
+        assert(*json::parse(two) == json::A().add(new json::P(2)));
+        assert(two.good());
+        assert(json::parse(two)->asPrimitive().number() == 3);
+        assert(two.eof() && !two.fail());
+
+        pipe_buffer b{ "{\"a\": [1, \"]\\\"\"]} [2] 3 \"x\"" };
+        std::istream in{ &b };
+        assert(*json::parse(in) == json::O().set("a", &(new json::A())->add(new json::P(1)).add(new json::P("]\""))));
+        assert(*json::parse(in) == json::A().add(new json::P(2)));
+        assert(json::parse(in)->asPrimitive().number() == 3);
+        assert(in.good());
+        assert(json::parse(in)->asPrimitive().literal() == "x");
+        assert(!in.fail());
+    }
+
+    assert(*json::parse(ss.str()) == k);
+    assert(*json::parse(std::string_view{ "[1, \"a\", {}]" }) == json::A().add(new json::P(1)).add(new json::P("a")).add(new json::O()));
+
+    { // a buffer holds exactly one value, whitespace aside
+        for (const std::string_view s : { "[1]]", "{} x", "1 2", "true false", "\"a\",", "[1] [2]" }) {
+            bool thrown = false;
+            try { json::parse(s); } catch (const std::runtime_error &) { thrown = true; }
+            assert(thrown);
+            thrown = false;
+            try { json::document().parse(s); } catch (const std::runtime_error &) { thrown = true; }
+            assert(thrown);
+            thrown = false;
+            try { json::compact::parse(s); } catch (const std::runtime_error &) { thrown = true; }
+            assert(thrown);
+            thrown = false;
+            try { json::tape().parse(s); } catch (const std::runtime_error &) { thrown = true; }
+            assert(thrown);
+            thrown = false;
+            json::sax::handler h;
+            try { json::sax::parse(s, h); } catch (const std::runtime_error &) { thrown = true; }
+            assert(thrown);
+        }
+        assert(json::parse(std::string_view{ " \n[1]\t\r\n " })->asArray().size() == 1);
+    }
+
+    { // long literals and whitespace runs crossing scan blocks
+        const std::string pad(70, ' ');
+        const std::string text(50, 'x');
+        const auto l = json::parse(pad + "[" + pad + "\"" + text + "\\t" + text + "\\\"\"" + pad + "]" + pad);
+        assert(l->asArray().at(0)->asPrimitive().literal() == text + "\t" + text + "\"");
+
+        bool thrown = false;
+        try { json::parse(std::string_view{ "\"" "0123456789abcdef0123456789abcdef\n\"" }); } catch (const std::runtime_error &) { thrown = true; }
+        assert(thrown);
+    }
+
+    { // skipping subtrees with brackets at every offset of a scan block
+        for (std::size_t i = 0; i < 40; ++i) {
+            const std::string pad(i, ' ');
+            const auto doc = "{\"a\": [" + pad + "{\"x\": \"" + pad + "]}\\\"\"}" + pad + "], \"b\": 1}";
+            assert(json::lazy::parse(doc)["b"].integer() == 1);
+            assert(json::lazy::parse(doc)["a"].raw().size() == doc.size() - 15);
+        }
+    }
+
 }
@@ -0,0 +1,38 @@
+#include <cassert>
+#include <string>
+
+#include "json-lib/json.hpp"
+
+int main(int, char **) {
+
+    json::interned::key_table keys;
+
+    std::string text = "[";
+    for (int i = 0; i < 1000; ++i) { text += (i ? "," : "") + std::string(R"({"id": )") + std::to_string(i) + R"(, "name": "n", "tags": {"name": true}, "esc\"aped": null})"; }
+    text += "]";
+
+    const auto a = json::interned::parse(text, keys);
+    assert(keys.size() == 4);
+
+    { // one storage per distinct key
+        const auto & r0 = a->asArray().at(0)->asObject();
+        const auto & r1 = a->asArray().at(999)->asObject();
+        assert(r0.begin()->first.data() == r1.begin()->first.data());
+        assert(r1.at(keys.find("id"))->asPrimitive().number() == 999);
+        assert(r1.at(keys.find("tags"))->asObject().at(keys.find("name"))->asPrimitive().boolean() == json::True);
+        assert(r1.at(keys.find("esc\"aped")) == nullptr);
+        assert(!keys.find("missing") && r1.find(keys.find("missing")) == r1.end());
+    }
+
+    { // the table is reused across parses
+        const auto b = json::interned::parse(R"({"name": "x", "other": 1})", keys);
+        assert(keys.size() == 5);
+        assert(b->asObject().begin()->first == keys.find("name"));
+        assert(std::string_view(b->asObject().begin()->first) == "name");
+    }
+
+    // same text out as the default definition, keys in insertion order
+    assert(json::to_string(*json::interned::parse(R"({"b": [1, {"a": "\n"}], "a": {}})", keys)) == R"({"b":[1,{"a":"\n"}],"a":{}})");
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <cassert>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+
+#include "json-lib/json.hpp"
+
+int main(int, char **) {
+
+    { // newline delimited, concatenated and scalar documents from a buffer
+        const std::string text = "{\"a\": 1}\n[1, 2]\n\n  {\"b\": \"}\\\"{\"}{\"c\": []}\"s\" 12 true null -3.5e1\n";
+        json::document_stream s{ text };
+        std::string out;
+        for (const auto & d : s) { out += json::to_string(*d) + "|"; }
+        assert(out == R"({"a":1}|[1,2]|{"b":"}\"{"}|{"c":[]}|"s"|12|true|null|-35|)");
+        assert(s.count() == 9);
+        assert(!s.next());
+    }
+
+    { // documents split across tiny chunks of a stream, the window grows for the large one
+        std::string text;
+        for (int i = 0; i < 2000; ++i) { text += "{\"id\": " + std::to_string(i) + ", \"name\": \"record\", \"v\": [1, 2, 3]}\n"; }
+        text += "[" + std::string(1000, ' ') + "\"" + std::string(5000, 'x') + "\"]\n";
+        text += "12345";
+
+        std::stringstream ss{ text };
+        json::document_stream s{ ss, 7 };
+        int i = 0;
+        std::size_t reserved = 0;
+        while (s.next() && i < 2000) {
+            assert(s.root()->asObject().at("id")->asPrimitive().number() == i);
+            if (i == 100) { reserved = s.bytesReserved(); }
+            if (i > 100) { assert(s.bytesReserved() == reserved); }
+            ++i;
+        }
+        assert(i == 2000);
+        assert(s.root()->asArray().at(0)->asPrimitive().literal().size() == 5000);
+        assert(s.next() && s.root()->asPrimitive().number() == 12345);
+        assert(!s.next());
+    }
+
+    { // empty input
+        std::stringstream ss{ " \n\n " };
+        json::document_stream s{ ss };
+        assert(s.begin() == s.end());
+    }
+
+    { // malformed documents
+        const char * bad[] = { "{\"a\": 1}\n{\"a\" 1}", "[1, 2", "truex", "1,2", "{} ]" };
+        for (auto b : bad) {
+            json::document_stream s{ std::string_view(b) };
+            bool thrown = false;
+            try {
+                while (s.next()) {}
+            } catch (const std::runtime_error &) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+    }
+
+    return 0;
+}
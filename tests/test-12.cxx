@@ -0,0 +1,57 @@
+#include <cassert>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "json-lib/json.hpp"
+
+int main(int, char **) {
+
+    // skewed document sizes, every 500th document is far larger than the rest
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += "{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\", \"b\"], \"pad\": \"" + std::string(i % 500 == 0 ? 20000 : i % 7, 'x') + "\"}\n";
+        if (i % 1000 == 0) { text += "\n  " + std::to_string(i) + " \"s\"\n"; }
+    }
+
+    std::vector<std::string> expected;
+    for (const auto & d : json::document_stream{ text }) { expected.push_back(json::to_string(*d)); }
+
+    for (std::size_t threads : { 1, 3, 8 }) {
+        std::vector<std::string> out;
+        const auto n = json::parallel::parse(text, [&](const json::arena::var::ptr_t & d) { out.push_back(json::to_string(*d)); }, { threads, 1 << 12 });
+        assert(n == expected.size());
+        assert(out == expected);
+    }
+
+    { // defaults, a buffer without a final newline
+        std::size_t n = 0;
+        assert(json::parallel::parse("[1]\n[2]\n[3]", [&](const json::arena::var::ptr_t & d) { assert(d->asArray().at(0)->asPrimitive().number() == ++n); }) == 3);
+        assert(json::parallel::parse("  \n ", [](const json::arena::var::ptr_t &) { assert(false); }) == 0);
+    }
+
+    { // a malformed document anywhere is reported
+        auto bad = text;
+        bad.insert(bad.size() / 2, "{\"a\" 1}\n");
+        bool thrown = false;
+        try {
+            json::parallel::parse(bad, [](const json::arena::var::ptr_t &) {}, { 4, 1 << 12 });
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    { // the callback can abort by throwing, workers are stopped
+        std::size_t n = 0;
+        bool thrown = false;
+        try {
+            json::parallel::parse(text, [&](const json::arena::var::ptr_t &) { if (++n == 10) { throw std::logic_error("stop"); } }, { 4, 1 << 12 });
+        } catch (const std::logic_error &) {
+            thrown = true;
+        }
+        assert(thrown && n == 10);
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <cassert>
+#include <string>
+#include <stdexcept>
+
+#include "json-lib/json.hpp"
+
+template<typename f_t>
+static bool throws(f_t && f) {
+    try {
+        f();
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+int main(int, char **) {
+
+    // a root array of uneven elements and a root object with duplicate keys, large enough to be split
+    std::string array = "[";
+    std::string object = "{";
+    for (int i = 0; i < 4000; ++i) {
+        const auto v = i % 3 == 0 ? "{\"id\": " + std::to_string(i) + ", \"s\": \"a,]}\\\"" + std::string(i % 500 == 0 ? 5000 : 3, 'x') + "\", \"l\": [1, [2], {}]}"
+            : i % 3 == 1 ? std::to_string(i * 0.5) : "\"" + std::to_string(i) + "\"";
+        array += (i != 0 ? " ,\n " : " ") + v;
+        object += std::string(i != 0 ? ", " : "") + "\"k" + std::to_string(i % 3000) + "\" : " + v;
+    }
+    array += " ]";
+    object += "}";
+
+    for (const auto & text : { array, object }) {
+        const auto serial = json::to_string(*json::parse(text));
+        for (std::size_t threads : { 1, 2, 5 }) {
+            assert(json::to_string(*json::parse(text, json::parallel_options{ threads, 1 << 14 })) == serial);
+        }
+        assert(json::to_string(*json::parse(text, json::parallel_options{})) == serial);
+    }
+
+    // small or scalar documents take the serial path
+    assert(json::to_string(*json::parse("[1, 2]", json::parallel_options{ 4 })) == "[1,2]");
+    assert(json::to_string(*json::parse(" \"s\" ", json::parallel_options{ 4 })) == "\"s\"");
+    assert(json::parse(std::string(1 << 16, ' ') + "[]", json::parallel_options{ 4 })->asArray().empty());
+    assert(json::parse(std::string(1 << 16, ' ') + "{}", json::parallel_options{ 4 })->asObject().empty());
+
+    // errors in the top level or inside any range
+    const json::parallel_options o{ 3, 1 << 14 };
+    for (const auto at : { array.size() / 2, array.size() - 100, std::size_t(1) }) {
+        auto bad = array;
+        bad.insert(bad.find(',', at), ",");
+        assert(throws([&] { json::parse(bad, o); }));
+    }
+    assert(throws([&] { json::parse(array.substr(0, array.size() - 1), o); }));
+    assert(throws([&] { json::parse(array.substr(0, array.size() - 1) + ",]", o); }));
+    assert(throws([&] { json::parse(object.substr(0, object.size() - 1) + ", }", o); }));
+    assert(throws([&] { json::parse(object.substr(0, object.size() - 1) + ", \"k\": }", o); }));
+    assert(throws([&] { json::parse(array + " ]", o); }));
+    { // a trailing comma after many scalars, as the serial parse rejects it
+        std::string scalars = "[";
+        for (int i = 0; i < 20000; ++i) { scalars += "12345,"; }
+        scalars += "]";
+        assert(throws([&] { json::parse(scalars); }));
+        assert(throws([&] { json::parse(scalars, json::parallel_options{ 4 }); }));
+    }
+    assert(throws([&] { auto bad = array; bad[bad.find("\"s\"", array.size() / 2) + 3] = ' '; json::parse(bad, o); }));
+    assert(throws([&] { auto bad = object; bad[bad.find(" : ", object.size() / 2) + 1] = ' '; json::parse(bad, o); }));
+    assert(throws([&] { auto bad = array; bad[bad.find("{}", array.size() / 2)] = '['; json::parse(bad, o); }));
+
+    return 0;
+}
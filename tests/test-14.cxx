@@ -0,0 +1,67 @@
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "json-lib/json.hpp"
+
+template<typename f_t>
+static bool throws(f_t && f) {
+    try {
+        f();
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+static void writeFile(const char * path, const std::string & content) {
+    std::ofstream f{ path, std::ios::binary };
+    f << content;
+}
+
+int main(int, char **) {
+
+    const char * path = "test-14.json";
+    std::string text = R"({"name": "router", "escaped": "a\"b\\c\n", "items": [1, 2.5, true, null]})";
+    // longer than a page, so the mapping spans several
+    text.insert(text.size() - 1, ", \"pad\": \"" + std::string(10000, 'x') + "\"");
+    writeFile(path, text);
+
+    assert(json::to_string(*json::parse_file(path)) == json::to_string(*json::parse(text)));
+    assert(json::to_string(*json::parse_file(std::string(path))) == json::to_string(*json::parse(text)));
+
+    {
+        const json::file_document d{ path };
+        assert(json::to_string(*d.root()) == json::to_string(*json::parse(text)));
+        assert(d.size() == text.size());
+        const auto & o = d.root()->asObject();
+        assert(o.at("escaped")->asPrimitive().literal() == "a\"b\\c\n");
+        assert(o.at("pad")->asPrimitive().literal().size() == 10000);
+    }
+
+    // decoding in place never writes back to the file
+    {
+        std::ifstream f{ path, std::ios::binary };
+        const std::string content{ std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() };
+        assert(content == text);
+    }
+
+    {
+        json::details::mapped_file f{ path };
+        assert(f.isMapped() && std::string(f.data(), f.size()) == text);
+        auto moved = std::move(f);
+        assert(std::string(moved.data(), moved.size()) == text && f.size() == 0);
+    }
+
+    writeFile(path, "");
+    assert(throws([&] { json::parse_file(path); }));
+
+    std::remove(path);
+    assert(throws([&] { json::parse_file(path); }));
+    assert(throws([&] { json::file_document{ path }; }));
+
+    return 0;
+}
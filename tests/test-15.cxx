@@ -0,0 +1,84 @@
+#include <cassert>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+
+#include "json-lib/json.hpp"
+
+template<typename f_t>
+static bool throws(f_t && f) {
+    try {
+        f();
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+// feeds text in chunks of n bytes and finishes at the end
+static std::string chunked(std::string_view text, std::size_t n) {
+    json::push_parser p;
+    for (std::size_t i = 0; i < text.size(); i += n) {
+        const auto c = text.substr(i, n);
+        if (p.feed(c.data(), c.size()) == json::push_status::done) {
+            assert(i + p.consumed() == text.size() || text.find_first_not_of(" \n", i + p.consumed()) == std::string_view::npos);
+            return json::to_string(*p.take());
+        }
+        assert(p.consumed() == c.size());
+    }
+    p.finish();
+    return json::to_string(*p.take());
+}
+
+int main(int, char **) {
+
+    const std::string_view text = R"( {"name": "rou\"ter", "esc\\": "a\\\"bé\n", "n": [-12.5e-1, 0, 1234567, true, false, null, [], {}],
+        "nested": {"a": [{"b": [1, [2, [3]]]}]}, "": ""} )";
+    const auto expected = json::to_string(*json::parse(text));
+
+    // every chunk size cuts strings, escapes, numbers and words at every position
+    for (std::size_t n = 1; n <= text.size(); ++n) { assert(chunked(text, n) == expected); }
+
+    // scalar roots complete at a separator or at finish()
+    for (std::size_t n = 1; n <= 6; ++n) {
+        assert(chunked("123456", n) == "123456");
+        assert(chunked("\"str\"", n) == "\"str\"");
+        assert(chunked("false", n) == "false");
+    }
+
+    { // documents back to back, the rest of a chunk is fed again after take()
+        json::push_parser p;
+        std::string_view c = "[1] {\"a\": 2}\n3 ";
+        std::string out;
+        while (!c.empty()) {
+            if (p.feed(c) == json::push_status::more) { break; }
+            out += json::to_string(*p.take()) + "|";
+            c.remove_prefix(p.consumed());
+        }
+        assert(out == "[1]|{\"a\":2}|3|");
+        assert(throws([&] { p.finish(); }));
+    }
+
+    // malformed input is reported as soon as it is seen, a cut document at finish()
+    assert(throws([] { json::push_parser p; p.feed("[1, 2}"); }));
+    assert(throws([] { json::push_parser p; p.feed("{\"a\" 1"); }));
+    assert(throws([] { json::push_parser p; p.feed("[tru"); p.feed("x]"); }));
+    assert(throws([] { json::push_parser p; p.feed("[1.2."); p.feed("3]"); }));
+    assert(throws([] { json::push_parser p; p.feed("[\"abc"); p.finish(); }));
+    assert(throws([] { json::push_parser p; p.feed("  "); p.finish(); }));
+    assert(throws([] { json::push_parser p; p.feed("nul"); p.finish(); }));
+
+    { // reset drops a partial document
+        json::push_parser p;
+        assert(p.feed("{\"a\": [1, \"x") == json::push_status::more);
+        p.reset();
+        assert(p.feed("[2]") == json::push_status::done);
+        assert(json::to_string(*p.take()) == "[2]");
+        assert(p.feed("{\"a\": 1, \"b\"") == json::push_status::more);
+        p.reset();
+        assert(p.feed("{\"c\": [3]}") == json::push_status::done);
+        assert(json::to_string(*p.take()) == "{\"c\":[3]}");
+    }
+
+    return 0;
+}
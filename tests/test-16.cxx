@@ -0,0 +1,180 @@
+#include <cassert>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <coroutine>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "json-lib/json.hpp"
+
+// single threaded event loop, coroutines wait for a descriptor and are resumed by run()
+struct loop {
+    struct waiter {
+        int fd;
+        short events;
+        std::coroutine_handle<> h;
+    };
+
+    struct ready_t {
+        loop & l;
+        int fd;
+        short events;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { l.waiting.push_back({ fd, events, h }); }
+        void await_resume() const noexcept {}
+    };
+
+    std::vector<waiter> waiting;
+
+    void run() {
+        while (!waiting.empty()) {
+            std::vector<pollfd> fds;
+            for (const auto & w : waiting) { fds.push_back({ w.fd, w.events, 0 }); }
+            if (::poll(fds.data(), fds.size(), 5000) <= 0) { throw std::runtime_error("poll failed"); }
+            std::vector<std::coroutine_handle<>> ready;
+            std::vector<waiter> rest;
+            for (std::size_t i = 0; i < fds.size(); ++i) {
+                if (fds[i].revents != 0) {
+                    ready.push_back(waiting[i].h);
+                } else {
+                    rest.push_back(waiting[i]);
+                }
+            }
+            waiting.swap(rest);
+            for (auto h : ready) { h.resume(); }
+        }
+    }
+};
+
+struct fd_source {
+    loop & l;
+    int fd;
+
+    json::async::task<std::size_t> read(char * d, std::size_t n) {
+        for (;;) {
+            const auto r = ::read(fd, d, n);
+            if (r >= 0) { co_return static_cast<std::size_t>(r); }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) { throw std::runtime_error("read failed"); }
+            co_await loop::ready_t{ l, fd, POLLIN };
+        }
+    }
+};
+
+// waits before every write, so writers take turns
+struct fd_sink {
+    loop & l;
+    int fd;
+
+    json::async::task<std::size_t> write(const char * d, std::size_t n) {
+        for (;;) {
+            co_await loop::ready_t{ l, fd, POLLOUT };
+            const auto r = ::write(fd, d, n);
+            if (r >= 0) { co_return static_cast<std::size_t>(r); }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) { throw std::runtime_error("write failed"); }
+        }
+    }
+};
+
+static void socketPair(int (&fds)[2]) {
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) { throw std::runtime_error("socketpair failed"); }
+    for (auto fd : fds) { ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK); }
+}
+
+static json::async::task<void> send(loop & l, int fd, std::string text, std::size_t piece) {
+    fd_sink s{ l, fd };
+    for (std::size_t i = 0; i < text.size();) { i += co_await s.write(text.data() + i, text.size() - i < piece ? text.size() - i : piece); }
+    ::close(fd);
+}
+
+static json::async::task<std::string> receive(loop & l, int fd, int & inFlight, int & maxInFlight) {
+    fd_source s{ l, fd };
+    ++inFlight;
+    maxInFlight = inFlight > maxInFlight ? inFlight : maxInFlight;
+    const auto v = co_await json::async::parse(s, 16);
+    --inFlight;
+    ::close(fd);
+    co_return json::to_string(*v);
+}
+
+static json::async::task<void> print(loop & l, int fd, json::var::ptr_t v) {
+    fd_sink s{ l, fd };
+    co_await json::async::write(*v, s, 2, 64);
+    ::close(fd);
+}
+
+int main(int, char **) {
+
+    { // many parses in flight on one thread, the input trickles in a few bytes at a time
+        const int count = 64;
+        loop l;
+        std::vector<json::async::task<void>> senders;
+        std::vector<json::async::task<std::string>> receivers;
+        std::vector<std::string> expected;
+        int inFlight = 0;
+        int maxInFlight = 0;
+        for (int i = 0; i < count; ++i) {
+            const auto text = "{\"id\": " + std::to_string(i) + ", \"name\": \"item \\\"" + std::to_string(i) + "\\\"\", \"values\": [" + std::string(i, '1') + "0, true, null, -2.5]}";
+            expected.push_back(json::to_string(*json::parse(text)));
+            int fds[2];
+            socketPair(fds);
+            receivers.push_back(receive(l, fds[0], inFlight, maxInFlight));
+            senders.push_back(send(l, fds[1], text, 1 + i % 7));
+        }
+        for (auto & t : receivers) { t.start(); }
+        for (auto & t : senders) { t.start(); }
+        l.run();
+        assert(maxInFlight == count && inFlight == 0);
+        for (int i = 0; i < count; ++i) {
+            assert(senders[i].done());
+            assert(receivers[i].result() == expected[i]);
+        }
+    }
+
+    { // a document printed into a socket while it is parsed from the other end, scalar roots end with the input
+        const std::string text = R"({"a": [1, 2, {"b": "c"}], "d": "eA", "f": [)" + std::string(200, '[') + std::string(200, ']') + "]}";
+        for (const auto & t : { text, std::string("12345") }) {
+            loop l;
+            int fds[2];
+            socketPair(fds);
+            int inFlight = 0;
+            int maxInFlight = 0;
+            auto p = print(l, fds[1], json::parse(t));
+            auto r = receive(l, fds[0], inFlight, maxInFlight);
+            p.start();
+            r.start();
+            l.run();
+            assert(p.done());
+            assert(r.result() == json::to_string(*json::parse(t)));
+        }
+    }
+
+    { // errors surface from the awaited task
+        loop l;
+        int fds[2];
+        socketPair(fds);
+        int inFlight = 0;
+        int maxInFlight = 0;
+        auto s = send(l, fds[1], "[1, 2", 2);
+        auto r = receive(l, fds[0], inFlight, maxInFlight);
+        r.start();
+        s.start();
+        l.run();
+        bool thrown = false;
+        try {
+            r.result();
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+        ::close(fds[0]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <cassert>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+
+#include "json-lib/json.hpp"
+
+int main(int, char **) {
+
+    const std::string_view text = R"( {"name": "a\"b\\c", "items": [1, 2.5, [true, false, null], {"k": []}], "empty": {}, "s": "xyz"} )";
+
+    { // parse counters
+        json::parse_stats s;
+        const auto v = json::parse(text, s);
+        assert(v->asObject().size() == 4);
+        assert(s.documents == 1);
+        assert(s.bytes == text.size() - 1);
+        assert(s.objects == 3 && s.arrays == 3 && s.keys == 5);
+        assert(s.literals == 2 && s.numbers == 2 && s.booleans == 2 && s.nulls == 1);
+        assert(s.values() == 13);
+        assert(s.maxDepth == 4);
+        assert(s.escapes == 2);
+        assert(s.literalBytes == std::string_view("nameitemskemptys").size() + std::string_view("a\"b\\c").size() + 3);
+        assert(s.arenaBytes == 0);
+        // every value made and every literal and key copied
+        assert(s.allocations == 13 + 2 + 5);
+
+        // counters add up over parses, depth keeps the largest
+        json::parse("[[[[1]]]]", s);
+        assert(s.documents == 2 && s.maxDepth == 4 && s.numbers == 3);
+        json::parse("[[[[[1]]]]]", s);
+        assert(s.maxDepth == 5);
+        assert(s.time.count() > 0);
+
+        // bytes are counted as decoded, a malformed escape still fails
+        json::parse_stats u;
+        json::parse(R"(["\u00e9\ud83d\ude00"])", u);
+        assert(u.literalBytes == 2 + 4 && u.escapes == 2);
+        bool thrown = false;
+        try {
+            json::parse(R"(["\u12x4"])", u);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    { // arena documents also report arena bytes, in-situ views count literals before they are decoded
+        json::parse_stats s;
+        json::document d;
+        d.parse(text, s);
+        assert(s.arenaBytes == d.bytesAllocated() && s.arenaBytes > 0);
+
+        json::parse_stats h;
+        json::parse(text, h);
+
+        json::parse_stats v;
+        json::view_document vd;
+        vd.parse(text, v);
+        assert(v.literalBytes == h.literalBytes && v.escapes == h.escapes);
+        assert(s.allocations == h.allocations && v.allocations == h.values());
+        assert(s.values() == h.values() && s.maxDepth == h.maxDepth);
+
+        // compact values allocate for containers, short literals and keys fit the value and the string buffers
+        json::parse_stats c;
+        using compact_parser = json::details::parser<json::compact::definition, json::details::compact_factory<json::compact::definition>, json::details::stats_recorder>;
+        compact_parser::parse(text.data(), text.data() + text.size(), {}, json::details::stats_recorder{ &c });
+        assert(c.values() == h.values() && c.allocations == 6);
+
+        // a long literal is decoded into a string of its own and copied into the value, a long key only decoded
+        const std::string longText(40, 'x');
+        json::parse_stats k;
+        const std::string literals = R"(["short", ")" + longText + R"("])";
+        compact_parser::parse(literals.data(), literals.data() + literals.size(), {}, json::details::stats_recorder{ &k });
+        assert(k.allocations == 1 + 2);
+        json::parse_stats o;
+        const auto keyed = "{\"" + longText + "\": 1, \"k\": \"v\"}";
+        compact_parser::parse(keyed.data(), keyed.data() + keyed.size(), {}, json::details::stats_recorder{ &o });
+        assert(o.allocations == 1 + 1);
+    }
+
+    { // print counters, to a string and through a sink
+        const auto v = json::parse(text);
+        json::print_stats s;
+        const auto out = json::to_string(*v, s);
+        assert(out == json::to_string(*v));
+        assert(s.documents == 1 && s.bytes == out.size());
+        assert(s.values == 13 && s.maxDepth == 4 && s.escapes == 2 && s.chunks == 0);
+
+        json::print_stats k;
+        std::string sunk;
+        auto sink = [&](const char * d, std::size_t n) { sunk.append(d, n); };
+        json::write(*v, sink, k, 2);
+        assert(sunk == json::to_string(*v, 2));
+        assert(k.bytes == sunk.size() && k.chunks == 1 && k.values == 13);
+
+        // compact values and tapes print through the same writer
+        json::print_stats c;
+        json::to_string(json::compact::parse(text), c);
+        assert(c.values == 13 && c.escapes == 2);
+    }
+
+    return 0;
+}
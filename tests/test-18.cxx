@@ -0,0 +1,211 @@
+#include <cassert>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+#include "json-lib/json.hpp"
+
+template<typename parse_t>
+static json::limit_error failure(parse_t parse) {
+    try {
+        parse();
+    } catch (const json::limit_error & e) {
+        return e;
+    }
+    assert(false);
+    throw std::logic_error("no limit exceeded");
+}
+
+int main(int, char **) {
+
+    const std::string_view text = R"({"a": [1, 2, {"b": [3]}], "s": "hello"})";
+
+    { // within limits the tree is the same as an unchecked parse
+        json::parse_limits l;
+        l.maxDepth = 4;
+        l.maxBytes = text.size();
+        l.maxStringLength = 5;
+        l.maxNodes = 8;
+        const auto v = json::parse(text, l);
+        assert(json::to_string(*v) == json::to_string(*json::parse(text)));
+    }
+
+    { // depth, the offset is the opening bracket
+        json::parse_limits l;
+        l.maxDepth = 3;
+        const auto e = failure([&] { json::parse(text, l); });
+        assert(e.which == json::limit::depth);
+        assert(e.offset == text.find("[3]"));
+        assert(std::string(e.what()).find("depth") != std::string::npos);
+
+        const std::string deep(100000, '[');
+        l.maxDepth = 64;
+        assert(failure([&] { json::parse(deep, l); }).offset == 64);
+    }
+
+    { // input bytes are refused before parsing
+        json::parse_limits l;
+        l.maxBytes = text.size() - 1;
+        const auto e = failure([&] { json::parse(text, l); });
+        assert(e.which == json::limit::bytes && e.offset == l.maxBytes);
+    }
+
+    { // string length as written, keys included
+        json::parse_limits l;
+        l.maxStringLength = 4;
+        const auto e = failure([&] { json::parse(text, l); });
+        assert(e.which == json::limit::string && e.offset == text.find("\"hello\""));
+
+        l.maxStringLength = 3;
+        assert(failure([&] { json::parse(R"({"long": 1})", l); }).offset == 1);
+        l.maxStringLength = 4;
+        assert(json::parse(R"(["a\"c"])", l)->asArray().size() == 1);
+        l.maxStringLength = 3;
+        assert(failure([&] { json::parse(R"(["a\"c"])", l); }).which == json::limit::string);
+    }
+
+    { // nodes, containers included
+        json::parse_limits l;
+        l.maxNodes = 7;
+        const auto e = failure([&] { json::parse(text, l); });
+        assert(e.which == json::limit::nodes && e.offset == text.find("\"hello\""));
+    }
+
+    { // memory, estimated for heap trees
+        json::parse_limits l;
+        l.maxMemory = 1000;
+        std::string numbers = "[1";
+        for (int i = 0; i < 1000; ++i) { numbers += ",1"; }
+        numbers += "]";
+        assert(failure([&] { json::parse(numbers, l); }).which == json::limit::memory);
+        l.maxMemory = 1 << 20;
+        assert(json::parse(numbers, l)->asArray().size() == 1001);
+    }
+
+    { // documents count their arena bytes
+        json::document d;
+        json::parse_limits l;
+        l.maxMemory = 4096;
+        std::string big = "[\"" + std::string(10000, 'x') + "\"]";
+        assert(failure([&] { d.parse(big, l); }).which == json::limit::memory);
+        l.maxMemory = 1 << 20;
+        d.parse(big, l);
+        assert(d.root()->asArray().size() == 1);
+
+        json::view_document v;
+        l.maxNodes = 2;
+        assert(failure([&] { v.parse("[1, 2]", l); }).offset == 4);
+        l.maxDepth = 0;
+        assert(failure([&] { v.parse("[]", l); }).which == json::limit::depth);
+    }
+
+    { // a push parser holds each document to the limits, offsets count across its chunks
+        json::parse_limits l;
+        l.maxDepth = 3;
+        json::bounded_push_parser p{ l };
+        const auto feed = [&](std::size_t chunk) {
+            for (std::size_t i = 0; i < text.size(); i += chunk) { p.feed(text.substr(i, chunk)); }
+        };
+        auto e = failure([&] { feed(5); });
+        assert(e.which == json::limit::depth && e.offset == text.find("[3]"));
+
+        p.reset();
+        l = {};
+        l.maxStringLength = 4;
+        json::bounded_push_parser q{ l };
+        e = failure([&] { for (std::size_t i = 0; i < text.size(); i += 3) { q.feed(text.substr(i, 3)); } });
+        assert(e.which == json::limit::string && e.offset == text.find("\"hello\""));
+
+        l = {};
+        l.maxNodes = 8;
+        l.maxBytes = text.size();
+        json::bounded_push_parser r{ l };
+        for (int k = 0; k < 2; ++k) {
+            for (std::size_t i = 0; i < text.size(); i += 4) { r.feed(text.substr(i, 4)); }
+            const auto v = r.take();
+            assert(json::to_string(*v) == json::to_string(*json::parse(text)));
+        }
+        l.maxBytes = text.size() - 1;
+        json::bounded_push_parser b{ l };
+        e = failure([&] { for (std::size_t i = 0; i < text.size(); i += 4) { b.feed(text.substr(i, 4)); } });
+        assert(e.which == json::limit::bytes);
+    }
+
+    { // a document stream holds every document to the limits on its own
+        json::parse_limits l;
+        l.maxNodes = 3;
+        const std::string_view docs = "[1, 2]\n[3, 4]\n[5, 6, 7]";
+        json::bounded_document_stream s{ docs, l };
+        const auto first = s.next();
+        const auto second = s.next();
+        assert(first && second);
+        auto e = failure([&] { s.next(); });
+        assert(e.which == json::limit::nodes && e.offset == 7);
+
+        std::stringstream ss{ std::string(docs) };
+        json::bounded_document_stream c{ ss, 4, l };
+        const auto chunkedFirst = c.next();
+        const auto chunkedSecond = c.next();
+        assert(chunkedFirst && chunkedSecond);
+        e = failure([&] { c.next(); });
+        assert(e.which == json::limit::nodes && e.offset == 7);
+
+        l = {};
+        l.maxMemory = 4096;
+        const auto big = "[1]\n[\"" + std::string(10000, 'x') + "\"]";
+        json::bounded_document_stream m{ big, l };
+        const auto small = m.next();
+        assert(small);
+        assert(failure([&] { m.next(); }).which == json::limit::memory);
+    }
+
+    { // parallel parses, the ranges of one document together and the documents of a batch each on its own
+        std::string many = "[";
+        for (int i = 0; i < 20000; ++i) { many += i == 0 ? "[1]" : ", [1]"; }
+        many += "]";
+        const json::parallel_options o{ 4, 1 << 14 };
+        json::parse_limits l;
+        l.maxNodes = 40001;
+        assert(json::parse(many, o, l)->asArray().size() == 20000);
+        l.maxNodes = 40000;
+        assert(failure([&] { json::parse(many, o, l); }).which == json::limit::nodes);
+        l = {};
+        l.maxDepth = 1;
+        const auto e = failure([&] { json::parse(many, o, l); });
+        assert(e.which == json::limit::depth && e.offset == 1);
+
+        std::string lines;
+        for (int i = 0; i < 2000; ++i) { lines += "[1, 2]\n"; }
+        l = {};
+        l.maxNodes = 3;
+        assert(json::parallel::parse(lines, [](const json::arena::var::ptr_t &) {}, { 4, 1 << 12 }, l) == 2000);
+        lines += "[1, 2, 3]\n";
+        assert(failure([&] { json::parallel::parse(lines, [](const json::arena::var::ptr_t &) {}, { 4, 1 << 12 }, l); }).which == json::limit::nodes);
+    }
+
+    { // tapes
+        json::parse_limits l;
+        l.maxDepth = 3;
+        json::tape t;
+        assert(failure([&] { t.parse(text, l); }).offset == text.find("[3]"));
+        l.maxDepth = 4;
+        t.parse(text, l);
+    }
+
+    { // malformed text still fails as before
+        json::parse_limits l;
+        l.maxStringLength = 8;
+        bool thrown = false;
+        try {
+            json::parse(R"(["abc)", l);
+        } catch (const json::limit_error &) {
+            assert(false);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+#define JSON_LIB_VALIDATE_UTF8 1
+
+#include <cassert>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+
+#include "json-lib/json.hpp"
+
+template<typename f_t>
+static bool throws(f_t && f) {
+    try {
+        f();
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+static std::string decoded(std::string_view text) { return json::parse(text)->asPrimitive().literal(); }
+
+static std::string view(std::string text) {
+    json::view_document d;
+    d.parseInSitu(&text[0], &text[0] + text.size());
+    return std::string(d.root()->asPrimitive().literal());
+}
+
+int main(int, char **) {
+
+    { // escapes are decoded to UTF-8 without a locale
+        assert(decoded(R"("\u0041\u00e9\u20AC")") == "A\xc3\xa9\xe2\x82\xac");
+        assert(decoded(R"("\ud83d\ude00")") == "\xf0\x9f\x98\x80");
+        assert(decoded(R"("a\uDBFF\uDFFFb")") == "a\xf4\x8f\xbf\xbf" "b");
+        assert(decoded(R"("\u0000")") == std::string(1, '\0'));
+        assert(decoded(R"("\u007f\u0080\u07ff\u0800\uffff")") == "\x7f\xc2\x80\xdf\xbf\xe0\xa0\x80\xef\xbf\xbf");
+
+        // every definition shares the decoder
+        assert(view(R"("x\ud83d\ude00y\u00e9")") == "x\xf0\x9f\x98\x80y\xc3\xa9");
+        assert(json::compact::parse(R"("\u20ac")").literal() == "\xe2\x82\xac");
+        json::document d;
+        assert(d.parse(R"({"\u00e9": "\ud83d\ude00"})").root()->asObject().count("\xc3\xa9") == 1);
+
+        // the serializer writes them back as raw UTF-8
+        assert(json::to_string(*json::parse(R"(["\u00e9\u0001"])")) == "[\"\xc3\xa9\\u0001\"]");
+    }
+
+    { // malformed escapes
+        assert(throws([] { decoded(R"("\u12g4")"); }));
+        assert(throws([] { decoded(R"("\u12")"); }));
+        assert(throws([] { decoded(R"("\ud800")"); }));
+        assert(throws([] { decoded(R"("\ud800x")"); }));
+        assert(throws([] { decoded(R"("\ud800A")"); }));
+        assert(throws([] { decoded(R"("\ud800\u0041")"); }));
+        assert(throws([] { decoded(R"("\udc00\ud800")"); }));
+        assert(throws([] { view(R"("\ude00")"); }));
+    }
+
+    { // raw literal text is validated with JSON_LIB_VALIDATE_UTF8
+        assert(decoded("\"caf\xc3\xa9 \xf0\x9f\x98\x80\"") == "caf\xc3\xa9 \xf0\x9f\x98\x80");
+        const char * bad[] = {
+            "\"\x80\"", "\"\xc0\xaf\"", "\"\xc3\"", "\"\xe0\x80\xaf\"", "\"\xed\xa0\x80\"",
+            "\"\xf4\x90\x80\x80\"", "\"\xf5\x80\x80\x80\"", "\"\xff\"", "\"ok\\n\xc3(\"",
+        };
+        for (const auto b : bad) {
+            assert(throws([&] { decoded(b); }));
+            assert(throws([&] { view(b); }));
+        }
+        // keys too, and long runs checked a block at a time
+        assert(throws([] { json::parse("{\"\xc3\": 1}"); }));
+        const std::string run(100, 'a');
+        assert(throws([&] { decoded("\"" + run + "\xe2\x82\"" ); }));
+        assert(decoded("\"" + run + "\xe2\x82\xac" + run + "\"").size() == 203);
+    }
+
+    { // whole texts
+        assert(json::is_valid_utf8(""));
+        assert(json::is_valid_utf8("{\"caf\xc3\xa9\": [\"\xf0\x9f\x98\x80\"]}"));
+        assert(!json::is_valid_utf8(std::string(64, 'a') + "\xc3"));
+        assert(!json::is_valid_utf8("\xef\xbf"));
+        assert(json::is_valid_utf8("\xef\xbf\xbf\xf4\x8f\xbf\xbf\x7f"));
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+
+#include <cassert>
+#include <string>
+#include <sstream>
+
+#include "json-lib/json.hpp"
+
+int main(int, char **) {
+
+    const auto text = R"(
+{
+    "a": 1,
+    "c": {
+            "d": 3
+        },
+    "e": null,
+    "f": [],
+    "g": [
+        4, 8, 16, 32, false
+    ],
+    "i" : "J",
+    "l": "a literal long enough to leave the small string buffer"
+}
+)";
+
+    json::document d;
+    d.parse(text);
+
+    const auto & j = d.root();
+    assert(j->asObject().at("a")->asPrimitive().number() == 1);
+    assert(j->asObject().at("c")->asObject().at("d")->asPrimitive().number() == 3);
+    assert(j->asObject().at("e") == nullptr);
+    assert(j->asObject().at("f")->asArray().size() == 0);
+    assert(j->asObject().at("g")->asArray().at(4)->asPrimitive().boolean() == json::False);
+    assert(j->asObject().at("i")->asPrimitive().literal() == "J");
+    assert(j->asObject().at("l")->asPrimitive().literal() == "a literal long enough to leave the small string buffer");
+
+    { // same output as the heap tree
+        std::stringstream a, b;
+        j->print(a, 2);
+        json::parse(text)->print(b, 2);
+        assert(a.str() == b.str());
+    }
+
+    { // nodes created through the document live in its arena
+        auto & o = *d.make<json::arena::object>();
+        o.set(d.literal("k"), d.make<json::arena::primitive>(d.literal("v")));
+        j->asObject().at("c")->asObject().set(d.literal("o"), &o);
+        assert(*j->asObject().at("c")->asObject().at("o")->asObject().at("k") == d.literal("v"));
+    }
+
+    { // a moved document keeps its arena, nodes made after the move live as long as the new owner
+        json::document o;
+        {
+            json::document m;
+            m.parse(R"({"a": [1]})");
+            json::document n{ std::move(m) };
+            o = std::move(n);
+        }
+        o.root()->asObject().at("a")->asArray().add(o.make<json::arena::primitive>(o.literal("a literal long enough to leave the small string buffer")));
+        o.root()->asObject().set(o.literal("b"), o.make<json::arena::array>());
+        for (int i = 0; i < 1000; ++i) { o.root()->asObject().at("b")->asArray().add(o.make<json::arena::primitive>(static_cast<double>(i))); }
+        assert(o.root()->asObject().at("a")->asArray().at(1)->asPrimitive().literal() == "a literal long enough to leave the small string buffer");
+        assert(o.root()->asObject().at("b")->asArray().size() == 1000);
+    }
+
+    { // reparse reuses the arena
+        const auto used = d.bytesAllocated();
+        assert(used > 0);
+        const auto reserved = d.bytesReserved();
+        d.parse("[1, 2, 3]");
+        assert(d.root()->asArray().size() == 3);
+        assert(d.bytesAllocated() < used);
+        assert(d.bytesReserved() <= reserved);
+    }
+
+    { // reset keeps the largest block, even when a smaller one was added after it
+        json::details::arena a(256);
+        a.allocate(100000);
+        a.allocate(40000);
+        a.reset();
+        const auto reserved = a.bytesReserved();
+        assert(reserved >= 100000 && a.bytesAllocated() == 0);
+        a.allocate(100000);
+        assert(a.bytesReserved() == reserved);
+    }
+
+    { // nesting depth is not limited by the call stack, arena nodes are never destroyed recursively
+        const std::size_t depth = 200000;
+        json::document n;
+        n.parse(std::string(depth, '[') + "{\"k\": [1]}" + std::string(depth, ']'));
+        auto p = n.root().get();
+        for (std::size_t i = 0; i < depth; ++i) { p = p->asArray().at(0).get(); }
+        assert(p->asObject().at("k")->asArray().size() == 1);
+    }
+
+    { // literals as views into a caller-owned buffer, escapes decoded in place
+        std::string b = R"({"plain": "text", "esc\"aped": "a\tb\\c\/d", "n": [1, "x"]})";
+        const auto data = b.data();
+        json::view_document v;
+        v.parseInSitu(b.data(), b.data() + b.size());
+
+        const auto & o = v.root()->asObject();
+        const auto & plain = o.at("plain")->asPrimitive().literal();
+        assert(plain == "text" && plain.data() >= data && plain.data() < data + b.size());
+        const auto & escaped = o.at("esc\"aped")->asPrimitive().literal();
+        assert(escaped == "a\tb\\c/d" && escaped.data() >= data && escaped.data() < data + b.size());
+        assert(o.at("n")->asArray().at(1)->asPrimitive().literal() == "x");
+        assert(json::to_string(*v.root()) == json::to_string(*json::parse(R"({"plain": "text", "esc\"aped": "a\tb\\c\/d", "n": [1, "x"]})")));
+    }
+
+    { // a view document keeps its own copy of the text
+        json::view_document v;
+        {
+            std::string b = text;
+            v.parse(b);
+        }
+        std::stringstream a, b;
+        v.root()->print(a, 2);
+        json::parse(text)->print(b, 2);
+        assert(a.str() == b.str());
+        assert(v.literal("k") == "k");
+    }
+
+}
@@ -0,0 +1,144 @@
+#include <cmath>
+#include <cassert>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+
+#include "json-lib/json.hpp"
+
+template<typename f_t>
+static bool throws(f_t && f) {
+    try {
+        f();
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+static std::string bytes(std::string_view hex) {
+    std::string r;
+    for (std::size_t i = 0; i + 1 < hex.size(); i += 2) { r.push_back(static_cast<char>(std::stoi(std::string(hex.substr(i, 2)), nullptr, 16))); }
+    return r;
+}
+
+static std::string hex(std::string_view b) {
+    static const char digits[] = "0123456789abcdef";
+    std::string r;
+    for (const auto c : b) {
+        r += digits[static_cast<unsigned char>(c) >> 4];
+        r += digits[static_cast<unsigned char>(c) & 0xf];
+    }
+    return r;
+}
+
+static std::string cbor(std::string_view h) { return json::to_string(*json::cbor::parse(bytes(h))); }
+static std::string msgpack(std::string_view h) { return json::to_string(*json::msgpack::parse(bytes(h))); }
+
+int main(int, char **) {
+
+    { // CBOR encoding, RFC 8949 appendix A where the value has a json form
+        assert(hex(json::cbor::encode(*json::parse("[0, 23, 24, 100, 1000, 1000000, 1000000000000]"))) == "870017181818641903e81a000f42401b000000e8d4a51000");
+        assert(hex(json::cbor::encode(*json::parse("[-1, -100, -1000]"))) == "832038633903e7");
+        assert(hex(json::cbor::encode(*json::parse("[1.5, 0.1, -4.1, 1e300]"))) == "84fa3fc00000fb3fb999999999999afbc010666666666666fb7e37e43c8800759c");
+        assert(hex(json::cbor::encode(*json::parse(R"([false, true, null, "", "a", "IETF", [], {}])"))) == "88f4f5f660616164494554468" "0a0");
+        assert(hex(json::cbor::encode(*json::parse(R"({"a": 1, "b": [2, 3]})"))) == "a26161016162820203");
+        assert(hex(json::cbor::encode(*json::parse("-0.0"))) == "fa80000000");
+    }
+
+    { // CBOR decoding, including forms the encoder does not produce
+        assert(cbor("1bffffffffffffffff") == "18446744073709551616");
+        assert(cbor("3bffffffffffffffff") == "-18446744073709551616");
+        assert(cbor("f93e00") == "1.5");
+        assert(cbor("f97bff") == "65504");
+        assert(json::cbor::parse(bytes("f90001"))->asPrimitive().number() == std::ldexp(1.0, -24));
+        assert(std::isinf(json::cbor::parse(bytes("f97c00"))->asPrimitive().number()));
+        assert(std::signbit(json::cbor::parse(bytes("f98000"))->asPrimitive().number()));
+        assert(cbor("f7") == "null");
+        assert(cbor("9fff") == "[]");
+        assert(cbor("9f018202039f0405ffff") == "[1,[2,3],[4,5]]");
+        assert(cbor("bf61610161629f0203ffff") == R"({"a":1,"b":[2,3]})");
+        assert(cbor("7f657374726561646d696e67ff") == R"("streaming")");
+        assert(cbor("c074323031332d30332d32315432303a30343a30305a") == R"("2013-03-21T20:04:00Z")");
+    }
+
+    { // MessagePack encoding picks the smallest form
+        assert(hex(json::msgpack::encode(*json::parse("[0, 127, 128, 255, 256, 65536, 4294967296]"))) == "97007fcc80ccffcd0100ce00010000cf0000000100000000");
+        assert(hex(json::msgpack::encode(*json::parse("[-1, -32, -33, -128, -129, -32769, -2147483649]"))) == "97ffe0d0dfd080d1ff7fd2ffff7fffd3ffffffff7fffffff");
+        assert(hex(json::msgpack::encode(*json::parse("[1.5, 0.1, false, true, null]"))) == "95ca3fc00000cb3fb999999999999ac2c3c0");
+        assert(hex(json::msgpack::encode(*json::parse(R"({"a": "bc"})"))) == "81a161a26263");
+
+        const std::string s(32, 'x');
+        assert(hex(json::msgpack::encode(*json::parse("\"" + s + "\""))).substr(0, 4) == "d920");
+        std::string sixteen = "[0";
+        for (int i = 1; i < 16; ++i) { sixteen += ",0"; }
+        sixteen += "]";
+        assert(hex(json::msgpack::encode(*json::parse(sixteen))).substr(0, 6) == "dc0010");
+        assert(msgpack(hex(json::msgpack::encode(*json::parse(sixteen)))) == json::to_string(*json::parse(sixteen)));
+    }
+
+    { // MessagePack decoding
+        assert(msgpack("d080") == "-128");
+        assert(msgpack("d1ff7f") == "-129");
+        assert(msgpack("cfffffffffffffffff") == "18446744073709551616");
+        assert(msgpack("da0003616263") == R"("abc")");
+        assert(msgpack("de0001a161c0") == R"({"a":null})");
+        assert(msgpack("dc0002c2c3") == "[false,true]");
+        assert(msgpack("df00000001a16101") == R"({"a":1})");
+    }
+
+    { // every definition round trips, compact keeps exact integers
+        const std::string_view text = R"({"name": "router", "ports": [80, 443, -1], "ratio": 0.25, "up": true, "tags": {"a": null, "é": ""}})";
+        const auto tree = json::parse(text);
+        for (const auto format : { json::binary_format::cbor, json::binary_format::msgpack }) {
+            const auto bin = format == json::binary_format::cbor ? json::cbor::encode(*tree) : json::msgpack::encode(*tree);
+
+            json::document d;
+            assert(json::to_string(*d.parse(bin, format).root()) == json::to_string(*tree));
+            json::view_document v;
+            assert(json::to_string(*v.parse(bin, format).root()) == json::to_string(*tree));
+
+            const auto c = json::details::binary_parser<json::compact::definition, json::details::compact_factory<json::compact::definition>>::parse(format, bin.data(), bin.data() + bin.size());
+            assert(json::to_string(c) == json::to_string(*tree));
+
+            json::interned::key_table keys;
+            const auto k = json::interned::parse(json::to_string(*tree), keys);
+            assert(json::to_string(*json::details::binary_parser<json::interned::definition, json::details::interning_factory<json::interned::definition>>::parse(format, bin.data(), bin.data() + bin.size(), json::details::interning_factory<json::interned::definition>{ &keys })) == json::to_string(*k));
+        }
+
+        const auto exact = json::compact::parse("[18446744073709551615, -9223372036854775808]", json::parse_options{ true });
+        assert(hex(json::cbor::encode(exact)) == "821bffffffffffffffff3b7fffffffffffffff");
+        assert(hex(json::msgpack::encode(exact)) == "92cfffffffffffffffffd38000000000000000");
+    }
+
+    { // malformed or json-less input throws, sizes larger than the input are refused before anything is reserved
+        assert(throws([] { json::cbor::parse(bytes("")); }));
+        assert(throws([] { json::cbor::parse(bytes("8301")); }));
+        assert(throws([] { json::cbor::parse(bytes("4161")); }));
+        assert(throws([] { json::cbor::parse(bytes("a10101")); }));
+        assert(throws([] { json::cbor::parse(bytes("ff")); }));
+        assert(throws([] { json::cbor::parse(bytes("1c")); }));
+        assert(throws([] { json::cbor::parse(bytes("9bffffffffffffffff")); }));
+        assert(throws([] { json::cbor::parse(bytes("7f4161ff")); }));
+        assert(throws([] { json::msgpack::parse(bytes("c1")); }));
+        assert(throws([] { json::msgpack::parse(bytes("c40161")); }));
+        assert(throws([] { json::msgpack::parse(bytes("d40100")); }));
+        assert(throws([] { json::msgpack::parse(bytes("81c0c0")); }));
+        assert(throws([] { json::msgpack::parse(bytes("ddffffffff")); }));
+        assert(throws([] { json::msgpack::parse(bytes("a3616263").substr(0, 3)); }));
+
+        // a whole input is one item
+        assert(throws([] { json::cbor::parse(bytes("0102")); }));
+        assert(throws([] { json::cbor::parse(bytes("8101ff")); }));
+        assert(throws([] { json::msgpack::parse(bytes("c0c0")); }));
+        assert(throws([] { json::msgpack::parse(bytes("9101c3")); }));
+        assert(throws([] { json::document().parse(bytes("a0a0"), json::binary_format::cbor); }));
+        assert(throws([] { json::document().parse(bytes("8000"), json::binary_format::msgpack); }));
+
+        // deep nesting is read without recursion
+        const std::string deep = std::string(10000, '\x81') + '\x80';
+        assert(json::cbor::parse(deep) != nullptr);
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+
+#include <cassert>
+#include <sstream>
+#include <typeinfo>
+
+#include "json-lib/json.hpp"
+
+int main(int, char **) {
+
+    static_assert(sizeof(json::compact::value) == 16, "compact value size");
+
+    const auto text = R"(
+{
+    "a": 1,
+    "c": {
+            "d": 3
+        },
+    "e": null,
+    "f": [],
+    "g": [
+        4, 8, 16, 32, false
+    ],
+    "i" : "J",
+    "k": 345.7,
+    "l": "a literal long enough to leave the inline buffer",
+    "m": "fifteen chars.."
+}
+)";
+
+    const auto j = json::compact::parse(text);
+
+    assert(j.isObject());
+    assert(j.asObject().at("a").asPrimitive().number() == 1);
+    assert(j.asObject().at("c").asObject().at("d").number() == 3);
+    assert(j.asObject().at("e") == nullptr);
+    assert(j.asObject().at("f").asArray().size() == 0);
+    assert(j.asObject().at("g").asArray().at(4) == json::False);
+    assert(j.asObject().at("i").literal() == "J");
+    assert(j.asObject().at("k") == 345.7);
+    assert(j.asObject().at("l").literal() == "a literal long enough to leave the inline buffer");
+    assert(j.asObject().at("m").literal() == "fifteen chars..");
+    assert(j.asObject().at("m").type() == json::value_type::literal);
+
+    { // accessors of the wrong type throw
+        bool thrown = false;
+        try { j.asObject().at("a").literal(); } catch (const std::bad_cast &) { thrown = true; }
+        assert(thrown);
+        assert(j.asObject().at("a").tryAsObject() == nullptr);
+    }
+
+    { // built trees compare, copy and move like parsed ones
+        using namespace json::compact;
+
+        auto k = object();
+        k.set("a", 1.0);
+        k.set("c", object().set("d", 3.0));
+        k.set("e", nullptr);
+        k.set("f", array());
+        k.set("g", array().add(4.0).add(8.0).add(16.0).add(32.0).add(json::False));
+        k.set("i", "J");
+        k.set("k", 345.7);
+        k.set("l", "a literal long enough to leave the inline buffer");
+        k.set("m", "fifteen chars..");
+
+        value v = k;
+        assert(v == j);
+
+        auto c = v;
+        assert(c == j);
+        auto m = std::move(c);
+        assert(m == j && c.isNull());
+        v.asObject().at("l") = "changed";
+        assert(v != j && m == j);
+    }
+
+    { // same output as the pointer tree
+        std::stringstream a, b;
+        j.print(a, 2);
+        json::parse(text)->print(b, 2);
+        assert(a.str() == b.str());
+    }
+
+}
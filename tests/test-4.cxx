@@ -0,0 +1,121 @@
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+
+#include "json-lib/json.hpp"
+
+static json::details::number_token read(const std::string & s) {
+    auto p = s.data();
+    auto t = json::details::readJsonNumber(p, s.data() + s.size());
+    assert(p == s.data() + s.size());
+    return t;
+}
+
+static bool same(const std::string & s) {
+    const auto a = read(s).floating();
+    const auto b = std::strtod(s.c_str(), nullptr);
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static std::string format(double d) {
+    char b[json::details::maxNumberChars];
+    return std::string(b, json::details::formatDouble(b, d));
+}
+
+static bool rejected(const std::string & s) {
+    try { json::parse(s); } catch (const std::runtime_error &) { return true; }
+    return false;
+}
+
+int main(int, char **) {
+
+    // fast path, exponents and correct rounding
+    for (auto s : {
+        "0", "-0", "1", "-1", "0.1", "0.25", "345.7", "-12.5e-3", "1e10", "1E+10", "1e-10", "123.456e-5",
+        "9007199254740993", "9007199254740992.5", "1.7976931348623157e308", "2.2250738585072011e-308",
+        "2.2250738585072014e-308", "4.9e-324", "2.4703282292062328e-324", "1e-400",
+        "123456789012345678901234567890", "3.14159265358979323846264338327950288",
+        "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203124",
+        "0.000000000000000000000000000000000001"
+    }) {
+        assert(same(s));
+    }
+
+    // integers stay exact when they fit 64 bits
+    assert(read("9223372036854775807").kind == json::details::number_token::kind_t::integer);
+    assert(read("9223372036854775807").i == INT64_MAX);
+    assert(read("-9223372036854775808").i == INT64_MIN);
+    assert(read("18446744073709551615").kind == json::details::number_token::kind_t::uinteger);
+    assert(read("18446744073709551615").u == UINT64_MAX);
+    assert(!read("18446744073709551616").isInteger());
+    assert(!read("1.0").isInteger() && !read("1e2").isInteger());
+
+    // grammar
+    assert(rejected("01"));
+    assert(rejected("1."));
+    assert(rejected(".5"));
+    assert(rejected("1e"));
+    assert(rejected("-"));
+    assert(rejected("+1"));
+    assert(rejected("1e999"));
+    assert(*json::parse("[1e2]")->asArray().at(0) == 100.0);
+
+    { // exact integers in compact values
+        const auto j = json::compact::parse("[9007199254740993, -5, 18446744073709551615, 1.5]", json::parse_options{ true });
+        assert(j.asArray().at(0).integer() == 9007199254740993);
+        assert(j.asArray().at(1).integer() == -5);
+        assert(j.asArray().at(2).uinteger() == UINT64_MAX);
+        assert(!j.asArray().at(3).isInteger() && j.asArray().at(3) == 1.5);
+        assert(j.asArray().at(1) == -5.0);
+
+        const auto d = json::compact::parse("[9007199254740993]");
+        assert(!d.asArray().at(0).isInteger());
+    }
+
+    // shortest round-trip formatting
+    assert(format(0) == "0");
+    assert(format(-0.0) == "-0");
+    assert(format(5) == "5");
+    assert(format(-42) == "-42");
+    assert(format(0.1) == "0.1");
+    assert(format(345.7) == "345.7");
+    assert(format(1.0 / 3) == "0.3333333333333333");
+    assert(format(1115111589.4371066) == "1115111589.4371066");
+    assert(format(123456789012.0) == "123456789012");
+    assert(format(1e21) == "1e+21");
+    assert(format(5e-324) == "5e-324");
+    assert(format(std::numeric_limits<double>::quiet_NaN()) == "null");
+    {
+        std::mt19937_64 r(7);
+        for (int i = 0; i < 100000; ++i) {
+            const auto bits = r();
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            if (d != d || d == std::numeric_limits<double>::infinity() || d == -std::numeric_limits<double>::infinity()) { continue; }
+            const auto f = format(d);
+            const auto p = read(f).floating();
+            assert(std::memcmp(&p, &d, sizeof(d)) == 0 || (d == 0 && p == 0));
+        }
+    }
+    {
+        std::stringstream a, b;
+        json::parse("[1115111589.4371066, 0.1, 100, -0.5e-7]")->print(a);
+        json::compact::parse(a.str()).print(b);
+        assert(a.str() == "[1115111589.4371066,0.1,100,-5e-08]" && b.str() == a.str());
+    }
+
+    { // integral number types of a definition
+        using definition = json::details::definition<json::details::unique_ptr, std::map, std::vector, std::int64_t, std::string, std::ostream>;
+        const std::string s = "[9007199254740993]";
+        assert(json::details::parse<definition>(s.data(), s.data() + s.size())->asArray().at(0)->asPrimitive().number() == 9007199254740993);
+    }
+
+}
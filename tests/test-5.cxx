@@ -0,0 +1,47 @@
+
+#include <cassert>
+#include <string>
+#include <sstream>
+
+#include "json-lib/json.hpp"
+
+int main(int, char **) {
+
+    const auto text = R"({"a":[1,2.5,-3e-07,true,false,null],"b":{"c":"q\"u\\o/te\n\t"},"d":[],"e":{}})";
+
+    const auto j = json::parse(text);
+
+    assert(json::to_string(*j) == R"({"a":[1,2.5,-3e-07,true,false,null],"b":{"c":"q\"u\\o\/te\n\t"},"d":[],"e":{}})");
+    assert(json::to_string(json::primitive(std::string("\x01\x1f"))) == R"("\u0001\u001f")");
+    assert(json::to_string(json::compact::parse(text)) == json::to_string(*j));
+
+    { // indented output matches print()
+        std::stringstream s;
+        j->print(s, 4);
+        assert(json::to_string(*j, 4) == s.str());
+        assert(json::to_string(*j, 2) == "{\n  \"a\": [\n    1,\n    2.5,\n    -3e-07,\n    true,\n    false,\n    null\n  ],\n"
+            "  \"b\": {\n    \"c\": \"q\\\"u\\\\o\\/te\\n\\t\"\n  },\n  \"d\": [],\n  \"e\": {}\n}");
+    }
+
+    { // indentation deeper than the precomputed run of spaces
+        auto d = json::parse("[[[[1]]]]");
+        const auto s = json::to_string(*d, 30);
+        assert(s.find("\n" + std::string(120, ' ') + "1\n" + std::string(90, ' ') + "]") != std::string::npos);
+        assert(*json::parse(s) == *d);
+    }
+
+    { // sinks receive large chunks that concatenate to the whole output
+        json::array a;
+        for (int i = 0; i < 20000; ++i) { a.add(new json::primitive("a literal long enough to fill a few chunks")); }
+        std::string out;
+        int calls = 0;
+        auto sink = [&](const char * d, std::size_t n) {
+            out.append(d, n);
+            ++calls;
+        };
+        json::write(a, sink);
+        assert(out == json::to_string(a));
+        assert(calls > 1 && calls < 20);
+    }
+
+}
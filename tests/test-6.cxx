@@ -0,0 +1,123 @@
+#include <cassert>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include "json-lib/json.hpp"
+
+// records every event as a token
+struct recorder : json::sax::handler {
+    std::string r;
+
+    bool onNull() { r += "null "; return true; }
+    bool onBoolean(bool b) { r += b ? "true " : "false "; return true; }
+    bool onNumber(const json::sax::number_token & n) {
+        r += n.isInteger() ? "i:" + std::to_string(n.as<std::int64_t>()) : "d:" + std::to_string(n.floating());
+        r += ' ';
+        return true;
+    }
+    bool onString(std::string_view s) { r += "s:" + std::string(s) + ' '; return true; }
+    bool onKey(std::string_view k) { r += "k:" + std::string(k) + ' '; return true; }
+    bool onObjectStart() { r += "{ "; return true; }
+    bool onObjectEnd() { r += "} "; return true; }
+    bool onArrayStart() { r += "[ "; return true; }
+    bool onArrayEnd() { r += "] "; return true; }
+};
+
+// extracts the top level "id" and stops
+struct find_id : json::sax::handler {
+    int depth = 0;
+    bool next = false;
+    std::int64_t id = -1;
+
+    bool onObjectStart() { ++depth; return true; }
+    bool onObjectEnd() { --depth; return true; }
+    bool onArrayStart() { ++depth; return true; }
+    bool onArrayEnd() { --depth; return true; }
+    bool onKey(std::string_view k) { next = depth == 1 && k == "id"; return true; }
+    bool onNumber(const json::sax::number_token & n) {
+        if (!next) { return true; }
+        id = n.as<std::int64_t>();
+        return false;
+    }
+};
+
+// checks that literals without escapes are views into the input
+struct views : json::sax::handler {
+    const char * begin;
+    const char * end;
+    int inside = 0;
+    int outside = 0;
+
+    bool onString(std::string_view s) {
+        ++(s.data() >= begin && s.data() + s.size() <= end ? inside : outside);
+        return true;
+    }
+};
+
+static bool throws(std::string_view s) {
+    json::sax::handler h;
+    try {
+        json::sax::parse(s, h);
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+int main(int, char **) {
+
+    {
+        recorder h;
+        assert(json::sax::parse(R"( {"a": [1, -2.5, true, false, null, "x\ny"], "b" : {}, "c": [], "d": {"e": "f"}} )", h));
+        assert(h.r == "{ k:a [ i:1 d:-2.500000 true false null s:x\ny ] k:b { } k:c [ ] k:d { k:e s:f } } ");
+    }
+
+    {
+        recorder h;
+        assert(json::sax::parse("\"top\"", h) && h.r == "s:top ");
+    }
+
+    { // early abort leaves the rest of the input untouched
+        const std::string_view s = R"({"meta": {"id": 1}, "id": 42, "items": [1, 2, 3, {"id": 7}]})";
+        find_id h;
+        json::details::sax_reader r;
+        assert(!r.parse(s.data(), s.data() + s.size(), h));
+        assert(h.id == 42);
+        assert(r.charsRead() == static_cast<long long>(s.find("42") + 2));
+    }
+
+    {
+        const std::string_view s = R"(["plain", "esc\"aped", {"key": "value"}])";
+        views h;
+        h.begin = s.data();
+        h.end = s.data() + s.size();
+        assert(json::sax::parse(s, h));
+        assert(h.inside == 2 && h.outside == 1);
+    }
+
+    { // the reader is reusable and stops after the first value
+        json::details::sax_reader r;
+        recorder h;
+        const std::string_view a = "[[[]]] [1]";
+        assert(r.parse(a.data(), a.data() + a.size(), h));
+        assert(r.charsRead() == 6);
+        assert(r.parse(a.data() + 6, a.data() + a.size(), h));
+        assert(h.r == "[ [ [ ] ] ] [ i:1 ] ");
+    }
+
+    assert(throws(""));
+    assert(throws("{"));
+    assert(throws("[1,]"));
+    assert(throws("[1 2]"));
+    assert(throws("{\"a\" 1}"));
+    assert(throws("{\"a\":1,}"));
+    assert(throws("{1:2}"));
+    assert(throws("[1}"));
+    assert(throws("tru"));
+    assert(throws("nul"));
+    assert(throws("\"unterminated"));
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <cassert>
+#include <string>
+#include <typeinfo>
+#include <stdexcept>
+#include <string_view>
+
+#include "json-lib/json.hpp"
+
+template<typename f_t>
+static bool throws(f_t && f) {
+    try {
+        f();
+    } catch (const std::exception &) {
+        return true;
+    }
+    return false;
+}
+
+int main(int, char **) {
+
+    const std::string_view text = R"( {
+        "skip": {"a": [1, {"b": "]}"}, "\"}"], "c": {}},
+        "meta": {"id": 42, "name": "router", "tags": ["x", "y\nz"], "ok": true, "nothing": null, "ratio": -2.5e-1},
+        "esc\"aped": 7,
+        "empty": [],
+        "items": [10, [20, 21], {"k": 30}, "40"]
+    } )";
+
+    const auto j = json::lazy::parse(text);
+    assert(j.isObject());
+
+    const auto m = j["meta"];
+    assert(m.isObject() && m.size() == 6);
+    assert(m["id"].integer() == 42);
+    assert(m["name"] == "router");
+    assert(m["name"].literal() == "router");
+    assert(m["tags"].size() == 2);
+    assert(m["tags"][1].literal() == "y\nz");
+    assert(m["ok"].boolean());
+    assert(m["nothing"].isNull());
+    assert(m["ratio"].number() == -0.25);
+    assert(!m.find("missing"));
+    assert(j["esc\"aped"].integer() == 7);
+    assert(j["empty"].size() == 0);
+    assert(j["items"].at(3) == "40");
+    assert(j["items"][2]["k"].integer() == 30);
+    assert(j["skip"].raw() == R"({"a": [1, {"b": "]}"}, "\"}"], "c": {}})");
+
+    { // literals without escapes are views into the buffer
+        std::string scratch;
+        const auto v = m["name"].literal(scratch);
+        assert(v.data() >= text.data() && v.data() < text.data() + text.size());
+        assert(m["tags"][1].literal(scratch) == "y\nz" && scratch == "y\nz");
+    }
+
+    {
+        std::string keys;
+        for (const auto & i : j.members()) { keys += i.key.literal() + ","; }
+        assert(keys == "skip,meta,esc\"aped,empty,items,");
+
+        long long sum = 0;
+        for (const auto & i : j["items"].elements()) {
+            if (i.type() == json::value_type::number) { sum += i.integer(); }
+            if (i.isArray()) {
+                for (const auto & k : i.elements()) { sum += k.integer(); }
+            }
+        }
+        assert(sum == 51);
+
+        int n = 0;
+        for (const auto & i : j["empty"].elements()) { (void)i; ++n; }
+        assert(n == 0);
+    }
+
+    // wrong types, missing members, malformed text where it is read
+    assert(throws([&] { j["missing"]; }));
+    assert(throws([&] { j["items"].at(4); }));
+    assert(throws([&] { j["meta"]["id"].literal(); }));
+    assert(throws([&] { j["items"]["k"]; }));
+    assert(throws([&] { j.at(0); }));
+    assert(throws([&] { json::lazy::parse("   "); }));
+    assert(throws([&] { json::lazy::parse(R"({"a" 1})")["a"]; }));
+    assert(throws([&] { json::lazy::parse(R"({"a": [1, 2)")["b"]; }));
+    assert(throws([&] { json::lazy::parse(R"([1 2])").at(1); }));
+
+    // a lookup stops at the first of duplicate keys
+    assert(json::lazy::parse(R"({"d": 1, "d": 2})")["d"].integer() == 1);
+    assert(json::parse(R"({"d": 1, "d": 2})")->asObject().at("d")->asPrimitive().number() == 2);
+
+    // unread subtrees are not validated
+    assert(json::lazy::parse(R"({"a": [1, ?], "b": 2})")["b"].integer() == 2);
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <cassert>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <typeinfo>
+#include <stdexcept>
+
+#include "json-lib/json.hpp"
+
+int main(int, char **) {
+
+    const auto text = R"({"a": 1, "b": [true, false, null, -2.5, 18446744073709551615, "x\ny"], "c": {}, "d": [], "e": {"f": {"g": "h"}}})";
+
+    json::tape t;
+    t.parse(text);
+
+    const auto o = t.root().asObject();
+    assert(o.size() == 5);
+    assert(o.at("a").integer() == 1 && o.at("a").number() == 1);
+    const auto b = o.at("b").asArray();
+    assert(b.size() == 6);
+    assert(b[0].boolean() && !b[1].boolean() && b[2].isNull());
+    assert(b[3].number() == -2.5);
+    assert(b[4].uinteger() == 18446744073709551615ull);
+    assert(b[5].literal() == "x\ny");
+    assert(o.at("c").asObject().empty() && o.at("d").asArray().empty());
+    assert(o["e"].asObject()["f"].asObject()["g"].literal() == "h");
+    assert(o.find("z") == o.end() && o.count("a") == 1);
+    assert(json::to_string(t.root()) == json::to_string(json::compact::parse(text, { true })));
+    assert(json::to_string(t.root(), 2) == json::to_string(json::compact::parse(text, { true }), 2));
+
+    { // duplicate keys are kept as written, lookups find the last
+        json::tape u;
+        const auto d = u.parse(R"({"k": 1, "k": 2})").root().asObject();
+        assert(d.size() == 2 && d.count("k") == 1);
+        assert(d["k"].integer() == 2);
+    }
+
+    { // members in document order
+        std::string keys;
+        json::tape u;
+        for (const auto & m : u.parse(R"({"z": 1, "y": 2, "x": 3})").root().asObject()) { keys += m.first; }
+        assert(keys == "zyx");
+    }
+
+    { // the buffers can be copied as bytes and reused
+        std::vector<std::uint64_t> e(t.entries().size());
+        std::memcpy(e.data(), t.entries().data(), e.size() * sizeof(e[0]));
+        const json::tape c{ std::move(e), t.literals() };
+        assert(json::to_string(c.root()) == json::to_string(t.root()));
+    }
+
+    { // sequential scans
+        std::string big = "[";
+        for (int i = 0; i < 100000; ++i) { big += (i ? "," : "") + std::to_string(i); }
+        big += "]";
+        t.parse(big);
+        std::int64_t sum = 0;
+        for (const auto & v : t.root().asArray()) { sum += v.integer(); }
+        assert(sum == 4999950000);
+        assert(t.root().asArray().size() == 100000);
+    }
+
+    { // scalar root
+        t.parse(" \"only\" ");
+        assert(t.root().literal() == "only");
+    }
+
+    bool thrown = false;
+    try { t.parse("[1, 2").root(); } catch (const std::runtime_error &) { thrown = true; }
+    assert(thrown);
+
+    // a failed parse leaves no partial tape behind
+    thrown = false;
+    try { t.parse("[1,2,"); } catch (const std::runtime_error &) { thrown = true; }
+    assert(thrown && t.entries().empty() && t.literals().empty());
+    thrown = false;
+    try { t.root(); } catch (const std::runtime_error &) { thrown = true; }
+    assert(thrown);
+
+    thrown = false;
+    try { json::tape().parse("[1]").root().asObject(); } catch (const std::bad_cast &) { thrown = true; }
+    assert(thrown);
+
+    return 0;
+}
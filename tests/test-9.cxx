@@ -0,0 +1,88 @@
+#include <cassert>
+#include <string>
+#include <stdexcept>
+
+#include "json-lib/json.hpp"
+
+template<typename map_t>
+static void containerBasics() {
+    map_t m;
+    assert(m.empty() && m.find("a") == m.end());
+    m["b"] = 2;
+    m["a"] = 1;
+    assert(m.emplace("c", 3).second && !m.emplace("a", 7).second);
+    assert(m.size() == 3 && m.at("a") == 1 && m.count("c") == 1 && m.count("d") == 0);
+    m["a"] = 5;
+    assert(m.at("a") == 5);
+    assert(m.erase("b") == 1 && m.erase("b") == 0 && m.size() == 2 && m.find("b") == m.end());
+
+    bool thrown = false;
+    try { m.at("b"); } catch (const std::out_of_range &) { thrown = true; }
+    assert(thrown);
+
+    for (int i = 0; i < 1000; ++i) { m[std::to_string(i)] = i; }
+    for (int i = 0; i < 1000; ++i) { assert(m.at(std::to_string(i)) == i); }
+    assert(m.size() == 1002);
+
+    auto c = m;
+    assert(c == m);
+    c["x"] = 0;
+    assert(c != m);
+}
+
+int main(int, char **) {
+
+    containerBasics<json::details::flat_map<std::string, int>>();
+    containerBasics<json::details::hash_map<std::string, int>>();
+
+    { // flat maps stay sorted, hash maps keep insertion order
+        json::details::flat_map<std::string, int> f;
+        json::details::hash_map<std::string, int> h;
+        for (auto k : { "z", "x", "y" }) {
+            f[k] = 0;
+            h[k] = 0;
+        }
+        std::string a, b;
+        for (const auto & i : f) { a += i.first; }
+        for (const auto & i : h) { b += i.first; }
+        assert(a == "xyz" && b == "zxy");
+    }
+
+    { // bulk build sorts once, later duplicates win
+        json::details::flat_map<std::string, int> f;
+        f.append("c", 1);
+        f.append("a", 2);
+        f.append("c", 3);
+        f.append("b", 4);
+        f.append("a", 5);
+        f.finish();
+        assert(f.size() == 3 && f.at("a") == 5 && f.at("b") == 4 && f.at("c") == 3);
+        assert(f.begin()->first == "a");
+    }
+
+    const auto text = R"({"b": 1, "a": {"z": [1, 2, {"q": null}], "y": "v"}, "c": [], "b": 2, "d": {}})";
+    const auto reference = json::to_string(*json::parse(text));
+
+    { // same output as std::map, including duplicate keys
+        const auto f = json::flat::parse(text);
+        assert(json::to_string(*f) == reference);
+        assert(f->asObject().at("b")->asPrimitive().number() == 2);
+        assert(f->asObject().at("a")->asObject().at("z")->asArray().at(2)->asObject().at("q") == nullptr);
+        assert(*f == *json::flat::parse(reference));
+    }
+
+    { // insertion ordered
+        const auto h = json::hashed::parse(text);
+        assert(json::to_string(*h) == R"({"b":2,"a":{"z":[1,2,{"q":null}],"y":"v"},"c":[],"d":{}})");
+        assert(h->asObject().at("a")->asObject().at("y")->asPrimitive().literal() == "v");
+        assert(*h == *json::hashed::parse(reference));
+    }
+
+    { // compact values over other object containers
+        using definition = json::details::compact_definition<json::details::flat_map, std::vector, double, std::string, std::ostream>;
+        using parser = json::details::parser<definition, json::details::compact_factory<definition>>;
+        assert(json::to_string(parser::parse(text, text + std::char_traits<char>::length(text))) == reference);
+    }
+
+    return 0;
+}